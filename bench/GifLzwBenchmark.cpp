@@ -0,0 +1,175 @@
+// Written by malekpour-dev.ir
+// GifLzwBenchmark measures GIF compression throughput of giflib's line-by-line encoder against
+// GifLzwEncoder, on the frames the exporter would write for every built-in template.
+
+#include "GifDeltaEncoder.h"
+#include "GifLzwEncoder.h"
+#include "PaletteQuantizer.h"
+#include "SceneRenderer.h"
+#include "SpinnerTemplates.h"
+#include <QElapsedTimer>
+#include <QImage>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <gif_lib.h>
+#include <vector>
+
+static const int kFrameSize = 400;
+static const int kFps = 30;
+static const int kRepeats = 5;
+
+// Counts the bytes giflib writes instead of storing them
+static int countBytes(GifFileType *gif, const GifByteType *, int length)
+{
+    *static_cast<size_t *>(gif->UserData) += length;
+    return length;
+}
+
+static ColorMapObject *makeColorMap(const QVector<QRgb> &palette)
+{
+    int size = 2;
+    while (size < palette.size())
+    {
+        size <<= 1;
+    }
+
+    ColorMapObject *colorMap = GifMakeMapObject(size, nullptr);
+    for (int i = 0; i < size; ++i)
+    {
+        QRgb color = i < palette.size() ? palette[i] : 0;
+        colorMap->Colors[i].Red = qRed(color);
+        colorMap->Colors[i].Green = qGreen(color);
+        colorMap->Colors[i].Blue = qBlue(color);
+    }
+    return colorMap;
+}
+
+// Frames of one loop of the scene as the exporter writes them: globally quantized, then
+// reduced to changed rectangles
+static std::vector<GifDeltaFrame> exportFrames(const Scene &scene, QVector<QRgb> &palette)
+{
+    SceneRenderer renderer;
+    renderer.setThreadCount(1);
+
+    std::vector<QImage> canvases;
+    PaletteQuantizer quantizer;
+    int frameCount = kFps * 2;
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        QImage canvas(scene.width(), scene.height(), QImage::Format_ARGB32_Premultiplied);
+        BLImage target;
+        target.createFromData(canvas.width(), canvas.height(), BL_FORMAT_PRGB32, canvas.bits(),
+                              canvas.bytesPerLine(), BL_DATA_ACCESS_RW, nullptr, nullptr);
+        renderer.render(scene, static_cast<double>(frame) / kFps, target);
+        canvas.convertTo(QImage::Format_ARGB32);
+        quantizer.addFrame(canvas);
+        canvases.push_back(canvas);
+    }
+
+    PaletteMap map(quantizer.palette());
+    palette = map.palette();
+
+    GifDeltaEncoder deltaEncoder(scene.width(), scene.height());
+    std::vector<GifDeltaFrame> frames;
+    GifDeltaFrame delta;
+    QImage indexed;
+    for (const QImage &canvas : canvases)
+    {
+        map.map(canvas, indexed);
+        if (deltaEncoder.addFrame(indexed, 100 / kFps, delta))
+            frames.push_back(delta);
+    }
+    if (deltaEncoder.finish(delta))
+        frames.push_back(delta);
+    return frames;
+}
+
+// Writes the frames as a GIF to a byte counter, returns the size of the file
+static size_t writeGif(const std::vector<GifDeltaFrame> &frames, const QVector<QRgb> &palette, bool builtinLzw)
+{
+    size_t written = 0;
+    int error;
+    GifFileType *gif = EGifOpen(&written, countBytes, &error);
+    if (!gif)
+    {
+        std::fprintf(stderr, "Error opening GIF: %s\n", GifErrorString(error));
+        std::exit(1);
+    }
+
+    ColorMapObject *colorMap = makeColorMap(palette);
+    EGifPutScreenDesc(gif, kFrameSize, kFrameSize, 8, 0, colorMap);
+    int codeSize = std::max(2, colorMap->BitsPerPixel);
+
+    GifLzwEncoder lzwEncoder;
+    std::vector<uint8_t> lzwData;
+    for (const GifDeltaFrame &frame : frames)
+    {
+        const QRect &rect = frame.rect;
+        EGifPutImageDesc(gif, rect.x(), rect.y(), rect.width(), rect.height(), false, nullptr);
+
+        if (builtinLzw)
+        {
+            lzwData.resize(GifLzwEncoder::maxEncodedSize(frame.pixels.size()));
+            lzwEncoder.encode(frame.pixels.data(), frame.pixels.size(), codeSize, lzwData.data());
+            for (size_t at = 0; lzwData[at] != 0; at += lzwData[at] + 1)
+            {
+                EGifPutCodeNext(gif, lzwData.data() + at);
+            }
+            EGifPutCodeNext(gif, nullptr);
+        }
+        else
+        {
+            for (int y = 0; y < rect.height(); ++y)
+            {
+                const uint8_t *scan = frame.pixels.data() + static_cast<size_t>(y) * rect.width();
+                EGifPutLine(gif, const_cast<GifByteType *>(scan), rect.width());
+            }
+        }
+    }
+
+    EGifCloseFile(gif, &error);
+    GifFreeMapObject(colorMap);
+    return written;
+}
+
+int main()
+{
+    std::printf("%-24s %8s %14s %14s %10s %10s\n", "template", "MPixels", "giflib MPix/s", "builtin MPix/s",
+                "giflib KB", "builtin KB");
+
+    for (const SpinnerTemplate &template_ : SpinnerTemplates::getTemplates())
+    {
+        QVector<QRgb> palette;
+        std::vector<GifDeltaFrame> frames = exportFrames(SpinnerTemplates::buildScene(template_, kFrameSize, kFrameSize), palette);
+
+        size_t pixels = 0;
+        for (const GifDeltaFrame &frame : frames)
+        {
+            pixels += frame.pixels.size();
+        }
+
+        double seconds[2];
+        size_t bytes[2];
+        for (int builtin = 0; builtin < 2; ++builtin)
+        {
+            // Best of several runs, the first one also warms up caches and tables
+            qint64 best = -1;
+            for (int run = 0; run < kRepeats; ++run)
+            {
+                QElapsedTimer timer;
+                timer.start();
+                bytes[builtin] = writeGif(frames, palette, builtin);
+                qint64 elapsed = timer.nsecsElapsed();
+                if (best < 0 || elapsed < best)
+                    best = elapsed;
+            }
+            seconds[builtin] = std::max<qint64>(best, 1) / 1e9;
+        }
+
+        double megapixels = pixels / 1e6;
+        std::printf("%-24s %8.2f %14.1f %14.1f %10.1f %10.1f\n", qPrintable(template_.name), megapixels,
+                    megapixels / seconds[0], megapixels / seconds[1], bytes[0] / 1024.0, bytes[1] / 1024.0);
+    }
+    return 0;
+}
@@ -3,13 +3,28 @@
 
 #include "CanvasWidget.h"
 #include <QContextMenuEvent>
+#include <QWindow>
+#include <algorithm>
 #include <cmath>
 
 CanvasWidget::CanvasWidget(QWidget *parent)
-    : QWidget(parent), m_nextId(1), m_selectedItemId(-1), m_isAnimating(false),
+    : QWidget(parent), m_selectedItemId(-1), m_isAnimating(false),
       m_isDragging(false)
 {
     setMouseTracking(true);
+    FrameScheduler::instance().registerClient(this);
+
+    // Emitted on the render thread, delivered here as a queued call
+    connect(&m_renderThread, &RenderThread::frameReady, this, [this](const QRegion &damage)
+            { update(damage); });
+    connect(&m_renderThread, &RenderThread::requestDone, this, [this]()
+            {
+        m_frameInFlight = false;
+        if (m_frameDeferred)
+        {
+            m_frameDeferred = false;
+            requestFrame();
+        } });
     setAutoFillBackground(true);
     QPalette pal = palette();
     pal.setColor(QPalette::Window, Qt::white);
@@ -29,13 +44,21 @@ CanvasWidget::CanvasWidget(QWidget *parent)
     connect(m_duplicateAction, &QAction::triggered, [this]()
             {
         if (m_selectedItemId != -1) {
-            auto *item = getSelectedItem();
-            if (item) {
-                  addSpinner(item->type, item->anim, item->position, item->size, item->color, item->speed, item->duration, item->preDelay, item->postDelay);
+            // Copy first, adding to the scene may move the items in memory
+            const SpinnerItem *selected = getSelectedItem();
+            if (selected) {
+                  SpinnerItem item = *selected;
+                  addSpinner(item.type, item.anim, item.position, item.size, item.color, item.speed, item.duration, item.preDelay, item.postDelay);
             }
         } });
 }
 
+CanvasWidget::~CanvasWidget()
+{
+    FrameScheduler::instance().unregisterClient(this);
+    m_renderThread.stop();
+}
+
 int CanvasWidget::addSpinner(SpinnerType type, SpinnerAnimation anim, QPointF percentPosition, int size, const QString &color,
                              float speed, float duration, float preDelay, float postDelay)
 {
@@ -46,103 +69,79 @@ int CanvasWidget::addSpinner(SpinnerType type, SpinnerAnimation anim, QPointF pe
 
     int newSize = canvasSize.width() * size / 100.0;
 
-    auto item = std::make_unique<SpinnerItem>(m_nextId++, type, anim, pixelPosition, newSize, color, speed, duration, preDelay, postDelay);
-    int id = item->id;
-    m_items.push_back(std::move(item));
+    const SpinnerItem &item = m_scene.addItem(type, anim, pixelPosition, newSize, color, speed, duration, preDelay,
+                                              postDelay);
+    int id = item.id;
+    reindexItem(item);
 
+    FrameScheduler::instance().wake();
     emit itemsChanged();
-    update();
+    sceneEdited();
     return id;
 }
 
 void CanvasWidget::removeSpinner(int id)
 {
-    auto it = std::find_if(m_items.begin(), m_items.end(),
-                           [id](const std::unique_ptr<SpinnerItem> &item)
-                           {
-                               return item->id == id;
-                           });
-
-    if (it != m_items.end())
+    if (m_scene.findItem(id))
     {
         if (m_selectedItemId == id)
         {
             m_selectedItemId = -1;
             emit itemDeselected();
         }
-        m_items.erase(it);
+        m_scene.removeItem(id);
+        m_hitIndex.remove(id);
+        if (m_hoveredItemId == id)
+        {
+            m_hoveredItemId = -1;
+            unsetCursor();
+        }
         emit itemsChanged();
-        update();
+        sceneEdited();
     }
 }
 
 void CanvasWidget::clearAll()
 {
-    m_items.clear();
+    m_scene.clear();
+    m_hitIndex.clear();
+    m_hoveredItemId = -1;
+    unsetCursor();
     m_selectedItemId = -1;
-    m_isAnimating = false; 
+    setAnimating(false);
     emit itemsChanged();
     emit itemDeselected();
-    update();
+    sceneEdited();
 }
 
 void CanvasWidget::selectItem(int id)
 {
-    
-    for (auto &item : m_items)
+    if (m_scene.findItem(id))
     {
-        item->isSelected = false;
-    }
-
-    
-    auto it = std::find_if(m_items.begin(), m_items.end(),
-                           [id](const std::unique_ptr<SpinnerItem> &item)
-                           {
-                               return item->id == id;
-                           });
-
-    if (it != m_items.end())
-    {
-        (*it)->isSelected = true;
         m_selectedItemId = id;
         emit itemSelected(id);
     }
 
-    update();
+    requestFrame();
 }
 
 void CanvasWidget::clearSelection()
 {
-    for (auto &item : m_items)
-    {
-        item->isSelected = false;
-    }
     m_selectedItemId = -1;
     emit itemDeselected();
-    update();
+    requestFrame();
 }
 
 SpinnerItem *CanvasWidget::getSelectedItem()
 {
-    auto it = std::find_if(m_items.begin(), m_items.end(),
-                           [this](const std::unique_ptr<SpinnerItem> &item)
-                           {
-                               return item->id == m_selectedItemId;
-                           });
-    return (it != m_items.end()) ? it->get() : nullptr;
+    return m_scene.findItem(m_selectedItemId);
 }
 
 void CanvasWidget::setItemProperty(int id, const QString &property, const QVariant &value)
 {
-    auto it = std::find_if(m_items.begin(), m_items.end(),
-                           [id](const std::unique_ptr<SpinnerItem> &item)
-                           {
-                               return item->id == id;
-                           });
-
-    if (it != m_items.end())
+    SpinnerItem *item = m_scene.findItem(id);
+    if (item)
     {
-        SpinnerItem *item = it->get();
         bool shouldResetAnimation = false;
 
         if (property == "size")
@@ -151,7 +150,7 @@ void CanvasWidget::setItemProperty(int id, const QString &property, const QVaria
         }
         else if (property == "color")
         {
-            item->color = value.value<QString>();
+            item->setColor(value.value<QString>());
         }
         else if (property == "speed")
         {
@@ -197,29 +196,27 @@ void CanvasWidget::setItemProperty(int id, const QString &property, const QVaria
             shouldResetAnimation = true;
         }
 
+        reindexItem(*item);
+        FrameScheduler::instance().wake();
+
+        // The render thread spots what changed by comparing the new snapshot with the last one
+        m_snapshot.reset();
         if (shouldResetAnimation)
         {
             resetAnimation();
         }
         else
         {
-            update();
+            requestFrame();
         }
     }
 }
 
 QVariant CanvasWidget::getItemProperty(int id, const QString &property)
 {
-    auto it = std::find_if(m_items.begin(), m_items.end(),
-                           [id](const std::unique_ptr<SpinnerItem> &item)
-                           {
-                               return item->id == id;
-                           });
-
-    if (it != m_items.end())
+    const SpinnerItem *item = m_scene.findItem(id);
+    if (item)
     {
-        SpinnerItem *item = it->get();
-
         if (property == "size")
             return item->size;
         if (property == "color")
@@ -256,11 +253,37 @@ void CanvasWidget::setAnimating(bool animating)
     if (m_isAnimating == animating)
         return;
 
+    // Pausing freezes the clock at the current time, playing resumes from there
+    m_clockOffset = clockTime();
+    m_clock.restart();
+
     m_isAnimating = animating;
-    if (!animating)
+    if (animating)
     {
-        update();
+        FrameScheduler::instance().wake();
     }
+    else
+    {
+        m_animationTime = m_clockOffset;
+        requestFrame();
+    }
+}
+
+bool CanvasWidget::wantsFrames() const
+{
+    if (!m_isAnimating || !isVisible() || !m_scene.hasAnimatedItems())
+        return false;
+
+    // Minimized windows, and on some platforms fully covered ones, are not exposed
+    const QWindow *handle = window()->windowHandle();
+    return handle && handle->isExposed();
+}
+
+double CanvasWidget::clockTime() const
+{
+    if (!m_isAnimating || !m_clock.isValid())
+        return m_clockOffset;
+    return m_clockOffset + m_clock.nsecsElapsed() / 1e9;
 }
 
 void CanvasWidget::updateAnimation()
@@ -268,285 +291,106 @@ void CanvasWidget::updateAnimation()
     if (!m_isAnimating || !isVisible())
         return;
 
-    bool needsUpdate = false;
-    for (auto &item : m_items)
-    {
-        if (!item)
-            continue;
-
-        float totalCycleTime = item->preDelay + item->duration + item->postDelay;
-        if (totalCycleTime <= 0)
-            continue;
+    // Time comes from the monotonic clock, a late or dropped tick skips ahead instead of
+    // slowing the animation down. Sampled once so the frame and hit tests agree on it.
+    m_animationTime = clockTime();
 
-        item->animationTime += (item->speed / 100) * 0.04f; 
+    // Never blocks, a render thread still busy with an older frame just gets the newer time
+    requestFrame();
 
-        
-        if (item->animationTime >= totalCycleTime)
-        {
-            item->animationTime = 0.0f;
-        }
-        needsUpdate = true;
-    }
-
-    if (needsUpdate)
-    {
-        update();
-    }
+    emit frameAdvanced();
 }
 
 void CanvasWidget::resetAnimation()
 {
-    for (auto &item : m_items)
-    {
-        item->animationTime = 0.0f;
-    }
-    update();
+    setAnimationTime(0.0);
 }
 
 void CanvasWidget::setAnimationTime(double t)
 {
-    for (auto &item : m_items)
-    {
-        item->animationTime = t;
-    }
-    update();
+    m_clockOffset = t;
+    m_clock.restart();
+    m_animationTime = t;
+    requestFrame();
 }
 
 double CanvasWidget::getAnimationDuration() const
 {
-    
-    double maxEnd = 0.0;
-    for (const auto &item : m_items)
-    {
-        double end = item->preDelay + item->duration + item->postDelay;
-        if (end > maxEnd)
-            maxEnd = end;
-    }
-    return maxEnd;
+    return m_scene.cycleDuration();
 }
 
-void CanvasWidget::paintEvent(QPaintEvent *)
+void CanvasWidget::paintEvent(QPaintEvent *event)
 {
-    if (!isVisible())
-        return;
-
-    QImage image(size(), QImage::Format_ARGB32);
-    image.fill(Qt::white); 
-
-    BLImage blImage;
-    blImage.createFromData(
-        image.width(),
-        image.height(),
-        BL_FORMAT_PRGB32,
-        image.bits(),
-        image.bytesPerLine(),
-        BL_DATA_ACCESS_RW,
-        nullptr,
-        nullptr);
+    // A window that was covered gets painted again once it is exposed
+    if (m_isAnimating)
+        FrameScheduler::instance().wake();
 
-    BLContext ctx(blImage);
-    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
-    ctx.clearAll();
+    // Rasterizing happens on the render thread, painting only blits its newest frame
+    const QImage &frame = m_renderThread.latestFrame();
+    if (frame.isNull())
+        return;
 
-    
-    for (const auto &item : m_items)
+    QPainter painter(this);
+    for (const QRect &rect : event->region())
     {
-        if (!item)
-            continue;
-        drawSpinner(ctx, *item);
-
-        
-        if (item->isSelected)
-        {
-            drawSelectionBox(ctx, *item);
-        }
+        painter.drawImage(rect, frame, rect);
     }
-
-    ctx.end();
-
-    QPainter painter(this);
-    painter.drawImage(0, 0, image);
 }
 
-void CanvasWidget::drawSpinner(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::requestFrame()
 {
-    ctx.save();
-    ctx.translate(item.position.x(), item.position.y());
-
-    
-    QColor c = QColor::fromString(item.color);
-    BLRgba32 color(c.red(), c.green(), c.blue(), c.alpha());
-    ctx.setFillStyle(color);
-    ctx.setStrokeStyle(color);
+    if (!isVisible() || size().isEmpty())
+        return;
 
-    
-    switch (item.anim)
+    // At most one request ahead of the render thread. Edits and ticks in the meantime fold
+    // into the next one, so a drag copies the scene once per rendered frame, not per mouse move.
+    if (m_frameInFlight)
     {
-    case SpinnerAnimation::None:
-        break;
-    case SpinnerAnimation::Rotate:
-        rotateAnimation(ctx, item);
-        break;
-    case SpinnerAnimation::Scale:
-        scaleAnimation(ctx, item);
-        break;
-    case SpinnerAnimation::Fade:
-        fadeAnimation(ctx, item);
-        break;
-    case SpinnerAnimation::Bounce:
-        bounceAnimation(ctx, item);
-        break;
-    case SpinnerAnimation::Slide:
-        slideAnimation(ctx, item);
-        break;
+        m_frameDeferred = true;
+        return;
     }
 
-    
-    switch (item.type)
-    {
-    case SpinnerType::Circle:
-        drawCircleSpinner(ctx, item);
-        break;
-    case SpinnerType::Ring:
-        drawRingSpinner(ctx, item);
-        break;
-    case SpinnerType::Rectangle:
-        drawRectangleSpinner(ctx, item);
-        break;
-    case SpinnerType::Square:
-        drawSquareSpinner(ctx, item);
-        break;
-    case SpinnerType::Star:
-        drawStarSpinner(ctx, item);
-        break;
-    case SpinnerType::Triangle:
-        drawTriangleSpinner(ctx, item);
-        break;
-    }
+    // Copied once per edit, playback keeps handing the same snapshot over
+    if (!m_snapshot)
+        m_snapshot = std::make_shared<const Scene>(m_scene);
 
-    ctx.restore();
+    RenderRequest request;
+    request.scene = m_snapshot;
+    request.time = m_animationTime;
+    request.width = width();
+    request.height = height();
+    request.selectedId = m_selectedItemId;
+    request.threadCount = m_renderer.threadCount();
+    m_renderThread.submit(std::move(request));
+    m_frameInFlight = true;
 }
 
-void CanvasWidget::drawCircleSpinner(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::sceneEdited()
 {
-    ctx.fillCircle(0, 0, item.size / 2.0f);
+    m_snapshot.reset();
+    requestFrame();
 }
 
-void CanvasWidget::drawRingSpinner(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::setRenderThreadCount(int threadCount)
 {
-    double outerRadius = item.size / 2.0f;
-    double innerRadius = outerRadius * 0.6;
-
-    
-    ctx.fillCircle(0, 0, outerRadius);
-
-    
-    ctx.setCompOp(BL_COMP_OP_DST_OUT);
-    ctx.fillCircle(0, 0, innerRadius);
-    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+    m_renderer.setThreadCount(threadCount);
+    requestFrame();
 }
 
-void CanvasWidget::drawRectangleSpinner(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::resizeEvent(QResizeEvent *event)
 {
-    double w = item.size;
-    double h = item.size;
-
-    QColor c = item.color;
-    BLRgba32 dotColor(c.red(), c.green(), c.blue(), c.alpha());
-    ctx.setFillStyle(dotColor);
-
-    ctx.fillRect(-w / 2.0, -h / 2.0, w, h);
-}
-
-void CanvasWidget::drawSquareSpinner(BLContext &ctx, const SpinnerItem &item)
-{
-    double w = item.size;
-    double h = item.size;
-
-    QColor c = item.color;
-    BLRgba32 dotColor(c.red(), c.green(), c.blue(), c.alpha());
-    ctx.setFillStyle(dotColor);
-
-    ctx.fillRect(-w / 2.0, -h / 2.0, w, h);
-}
-
-void CanvasWidget::drawStarSpinner(BLContext &ctx, const SpinnerItem &item)
-{
-    const int numPoints = 5;
-    const double outerRadius = item.size;
-    const double innerRadius = outerRadius * 0.4;
-
-    BLPoint pts[numPoints * 2];
-
-    for (int i = 0; i < numPoints * 2; ++i)
-    {
-        double angle = i * M_PI / numPoints;
-        double radius = (i % 2 == 0) ? outerRadius : innerRadius;
-        pts[i] = BLPoint(radius * std::cos(angle - M_PI / 2),
-                         radius * std::sin(angle - M_PI / 2));
-    }
-
-    ctx.fillPolygon(pts, numPoints * 2);
+    QWidget::resizeEvent(event);
+    m_scene.resize(width(), height());
+    sceneEdited();
 }
 
-void CanvasWidget::drawTriangleSpinner(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::showEvent(QShowEvent *event)
 {
-    double size = item.size;
-
-    BLPoint pts[3] = {
-        BLPoint(0, -size / 2.0),
-        BLPoint(size / 2.0, size / 2.0),
-        BLPoint(-size / 2.0, size / 2.0)};
+    QWidget::showEvent(event);
 
-    QColor c = QColor::fromString(item.color);
-    BLRgba32 color(c.red(), c.green(), c.blue(), c.alpha());
-    ctx.setFillStyle(color);
-    ctx.fillPolygon(pts, 3);
-}
-
-void CanvasWidget::drawSelectionBox(BLContext &ctx, const SpinnerItem &item)
-{
-    
-    double baseSize = item.size;
-    double padding = 10.0; 
-
-    
-    double actualSize = baseSize;
-    if (item.anim == SpinnerAnimation::Scale)
-    {
-        float totalCycleTime = item.preDelay + item.duration + item.postDelay;
-        float cyclePosition = fmod(item.animationTime, totalCycleTime);
-        if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
-        {
-            float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
-            float scale = 0.5f + 0.5f * (1.0f + std::sin(normalizedTime * 2.0f * M_PI));
-            actualSize = baseSize * scale;
-        }
-    }
-    
-    switch (item.type)
-    {
-    case SpinnerType::Star:
-        actualSize = std::max(actualSize, baseSize * 1.2);
-        break;
-    case SpinnerType::Triangle:
-        actualSize = std::max(actualSize, baseSize * 1.1);
-        break;        
-        break;
-    }
-
-    
-    double finalSize = actualSize + padding;
-
-    
-    BLRgba32 selectionColor(100, 150, 255, 128);
-    ctx.setStrokeStyle(selectionColor);
-    ctx.setStrokeWidth(2.0);
-
-    ctx.strokeRect(item.position.x() - finalSize / 2,
-                   item.position.y() - finalSize / 2,
-                   finalSize,
-                   finalSize);
+    // Also delivered when a minimized window is restored
+    FrameScheduler::instance().wake();
+    requestFrame();
 }
 
 void CanvasWidget::mousePressEvent(QMouseEvent *event)
@@ -578,7 +422,21 @@ void CanvasWidget::mouseMoveEvent(QMouseEvent *event)
         if (item)
         {
             item->position += delta;
-            update();
+            reindexItem(*item);
+            sceneEdited();
+        }
+    }
+    else
+    {
+        // Hover feedback, which items are under the cursor changes while they animate too
+        int hoveredId = findItemAt(event->position());
+        if (hoveredId != m_hoveredItemId)
+        {
+            m_hoveredItemId = hoveredId;
+            if (hoveredId != -1)
+                setCursor(Qt::PointingHandCursor);
+            else
+                unsetCursor();
         }
     }
 
@@ -603,117 +461,44 @@ void CanvasWidget::contextMenuEvent(QContextMenuEvent *event)
 
 int CanvasWidget::findItemAt(const QPointF &position) const
 {
-    
-    for (auto it = m_items.rbegin(); it != m_items.rend(); ++it)
-    {
-        QRectF bounds = getItemBounds(**it);
-        if (bounds.contains(position))
-        {
-            return (*it)->id;
-        }
-    }
-    return -1;
-}
-
-QRectF CanvasWidget::getItemBounds(const SpinnerItem &item) const
-{
-    float size = item.size;
-    float halfSize = size / 2.0f;
-    return QRectF(item.position.x() - halfSize,
-                  item.position.y() - halfSize,
-                  size, size);
-}
+    BLPoint point(position.x(), position.y());
 
-void CanvasWidget::rotateAnimation(BLContext &ctx, const SpinnerItem &item)
-{
-    float totalCycleTime = item.preDelay + item.duration + item.postDelay;
-    float cyclePosition = fmod(item.animationTime, totalCycleTime);
+    m_hitCandidates.clear();
+    m_hitIndex.query(point, m_hitCandidates);
+    sortByZOrder(m_hitCandidates);
 
-    if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
+    // Topmost first
+    for (auto it = m_hitCandidates.rbegin(); it != m_hitCandidates.rend(); ++it)
     {
-        float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
-        ctx.rotate(normalizedTime * 2.0f * M_PI);
-    }
-}
-
-void CanvasWidget::scaleAnimation(BLContext &ctx, const SpinnerItem &item)
-{
-    float totalCycleTime = item.preDelay + item.duration + item.postDelay;
-    float cyclePosition = fmod(item.animationTime, totalCycleTime);
-
-    if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
-    {
-        float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
-        float scale = 0.5f + 0.5f * (1.0f + std::sin(normalizedTime * 2.0f * M_PI));
-        ctx.scale(scale);
+        const SpinnerItem *item = m_scene.findItem(*it);
+        if (item && SceneRenderer::hitTest(*item, m_animationTime, point))
+            return item->id;
     }
+    return -1;
 }
 
-void CanvasWidget::fadeAnimation(BLContext &ctx, const SpinnerItem &item)
+QRectF CanvasWidget::getItemBounds(const SpinnerItem &item) const
 {
-    float totalCycleTime = item.preDelay + item.duration + item.postDelay;
-    float cyclePosition = fmod(item.animationTime, totalCycleTime);
-
-    if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
-    {
-        float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
-        
-        float alpha = 0.1f + 0.9f * (0.5f * (1.0f + std::sin(normalizedTime * 2.0f * M_PI)));
-
-        
-        QColor baseColor = QColor::fromString(item.color);
-
-        
-        BLRgba32 fadeColor(
-            baseColor.red(),
-            baseColor.green(),
-            baseColor.blue(),
-            static_cast<uint8_t>(alpha * 255.0f));
-
-        
-        ctx.setFillStyle(fadeColor);
-        ctx.setStrokeStyle(fadeColor);
-    }
+    BLBox box = SceneRenderer::itemBounds(item, m_animationTime);
+    return QRectF(box.x0, box.y0, box.x1 - box.x0, box.y1 - box.y0);
 }
 
-void CanvasWidget::bounceAnimation(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::reindexItem(const SpinnerItem &item)
 {
-    float totalCycleTime = item.preDelay + item.duration + item.postDelay;
-    float cyclePosition = fmod(item.animationTime, totalCycleTime);
-
-    if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
-    {
-        float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
-
-        
-        float bounceHeight = 20.0f; 
-        float verticalPos = std::abs(std::sin(normalizedTime * M_PI)) * bounceHeight;
-
-        
-        float verticalVelocity = std::cos(normalizedTime * M_PI);
-        float scaleX = 1.0f + 0.2f * std::abs(verticalVelocity); 
-        float scaleY = 1.0f - 0.2f * std::abs(verticalVelocity); 
-
-        
-        ctx.translate(0, -verticalPos); 
-        ctx.scale(scaleX, scaleY);
-    }
+    m_hitIndex.update(item.id, SceneRenderer::sweptBounds(item));
 }
 
-void CanvasWidget::slideAnimation(BLContext &ctx, const SpinnerItem &item)
+void CanvasWidget::sortByZOrder(std::vector<int> &ids) const
 {
-    float totalCycleTime = item.preDelay + item.duration + item.postDelay;
-    float cyclePosition = fmod(item.animationTime, totalCycleTime);
-
-    if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
-    {
-        float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
-        float offset = 20.0f * std::sin(normalizedTime * 2.0f * M_PI);
-        ctx.translate(offset, 0);
-    }
+    const auto &items = m_scene.items();
+    std::sort(ids.begin(), ids.end(),
+              [&items](int a, int b)
+              {
+                  return items.indexOf(a) < items.indexOf(b);
+              });
 }
 
-const std::vector<std::unique_ptr<SpinnerItem>> &CanvasWidget::getItems() const
+const SlotMap<SpinnerItem> &CanvasWidget::getItems() const
 {
-    return m_items;
-}
+    return m_scene.items();
+}
\ No newline at end of file
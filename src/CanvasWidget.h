@@ -10,60 +10,23 @@
 #include <QMenu>
 #include <QAction>
 #include <QVariant>
+#include <QElapsedTimer>
 #include <blend2d.h>
-#include <vector>
 #include <memory>
+#include <vector>
+#include "FrameScheduler.h"
+#include "RenderThread.h"
+#include "Scene.h"
+#include "SceneRenderer.h"
+#include "SpatialIndex.h"
 
-enum class SpinnerType
-{
-    Circle,
-    Ring,
-    Square,
-    Rectangle,
-    Triangle,
-    Star
-};
-
-enum class SpinnerAnimation
-{
-    None,
-    Rotate,
-    Scale,
-    Fade,
-    Bounce,
-    Slide
-};
-
-struct SpinnerItem
-{
-    int id;
-    SpinnerType type;
-    SpinnerAnimation anim;
-    QPointF position;
-    int size;
-    QString color;
-    float speed;
-    float animationTime;
-    bool isSelected;
-    QString name;
-    float duration;
-    float preDelay;  // Delay before animation starts in seconds
-    float postDelay; // Delay after animation completes in seconds
-
-    SpinnerItem(int itemId, SpinnerType spinnerType, SpinnerAnimation anim, QPointF pos, int itemSize, QString itemColor,
-                float itemSpeed, float itemDuration, float itemPreDelay = 0.0f, float itemPostDelay = 0.0f)
-        : id(itemId), type(spinnerType), anim(anim), position(pos), size(itemSize), color(itemColor),
-          speed(itemSpeed), animationTime(0.0f), duration(itemDuration),
-          preDelay(itemPreDelay), postDelay(itemPostDelay), isSelected(false),
-          name(QString("Spinner %1").arg(itemId)) {}
-};
-
-class CanvasWidget : public QWidget
+class CanvasWidget : public QWidget, public FrameClient
 {
     Q_OBJECT
 
 public:
     explicit CanvasWidget(QWidget *parent = nullptr);
+    ~CanvasWidget();
 
     // Item management
     int addSpinner(SpinnerType type, SpinnerAnimation anim, QPointF position, int size, const QString &color,
@@ -87,46 +50,72 @@ public:
     void setAnimating(bool animating);
     void updateAnimation();
     void resetAnimation();
+
+    // Whether the frame scheduler should tick this canvas: playing, on screen and with
+    // something that moves
+    bool wantsFrames() const override;
+    void advanceFrame() override { updateAnimation(); }
+    QScreen *frameScreen() const override { return screen(); }
     double getAnimationDuration() const;
 
-    const std::vector<std::unique_ptr<SpinnerItem>> &getItems() const;
+    const SlotMap<SpinnerItem> &getItems() const;
+    const Scene &scene() const { return m_scene; }
 
-    // Helper functions
+    // Rendering
+    void setRenderThreadCount(int threadCount);
+    const SceneRenderer &renderer() const { return m_renderer; }
+
+    // Helper functions. Hit tests look items up in the spatial index, then test the exact
+    // shape as it is drawn at the current animation time.
     int findItemAt(const QPointF &position) const;
     QRectF getItemBounds(const SpinnerItem &item) const;
 
-    // Drawing
-    void drawSpinner(BLContext &ctx, const SpinnerItem &item);
-
 signals:
     void itemSelected(int id);
     void itemDeselected();
     void itemsChanged();
 
+    // Emitted for every animation frame the canvas advances
+    void frameAdvanced();
+
 protected:
     void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void contextMenuEvent(QContextMenuEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
 
 private:
-    void drawCircleSpinner(BLContext &ctx, const SpinnerItem &item);
-    void drawRingSpinner(BLContext &ctx, const SpinnerItem &item);
-    void drawRectangleSpinner(BLContext &ctx, const SpinnerItem &item);
-    void drawSquareSpinner(BLContext &ctx, const SpinnerItem &item);
-    void drawStarSpinner(BLContext &ctx, const SpinnerItem &item);
-    void drawTriangleSpinner(BLContext &ctx, const SpinnerItem &item);
-    void drawSelectionBox(BLContext &ctx, const SpinnerItem &item);
-
-    void rotateAnimation(BLContext &ctx, const SpinnerItem &item);
-    void scaleAnimation(BLContext &ctx, const SpinnerItem &item);
-    void fadeAnimation(BLContext &ctx, const SpinnerItem &item);
-    void bounceAnimation(BLContext &ctx, const SpinnerItem &item);
-    void slideAnimation(BLContext &ctx, const SpinnerItem &item);
-
-    std::vector<std::unique_ptr<SpinnerItem>> m_items;
-    int m_nextId = 0;
+    // Asks the render thread for a frame of the current scene and time, or for one more once
+    // it is done with the frame it has. sceneEdited() also drops the snapshot, so the next
+    // frame is drawn from a fresh copy of the scene.
+    void requestFrame();
+    void sceneEdited();
+    void reindexItem(const SpinnerItem &item);
+    void sortByZOrder(std::vector<int> &ids) const;
+    double clockTime() const;
+
+    Scene m_scene;
+    SceneRenderer m_renderer; // Render settings, the render thread draws with its own renderer
+    double m_animationTime = 0.0; // Scene time of the last requested frame
+
+    // Frames are rasterized off the GUI thread from immutable copies of m_scene
+    RenderThread m_renderThread;
+    std::shared_ptr<const Scene> m_snapshot;
+    bool m_frameInFlight = false;
+    bool m_frameDeferred = false;
+
+    // Monotonic animation clock, scene time is m_clockOffset plus the time elapsed since it started
+    QElapsedTimer m_clock;
+    double m_clockOffset = 0.0;
+
+    // Swept bounds of every item, so hit tests stay valid while items animate
+    SpatialIndex m_hitIndex;
+    mutable std::vector<int> m_hitCandidates;
+    int m_hoveredItemId = -1;
+
     int m_selectedItemId = -1;
     bool m_isAnimating = false;
     bool m_isDragging = false;
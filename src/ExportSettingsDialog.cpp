@@ -0,0 +1,106 @@
+// Written by malekpour-dev.ir
+// ExportSettingsDialog edits the frame rate, output size, timing and GIF and PNG encoding
+// options every export uses.
+
+#include "ExportSettingsDialog.h"
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QVBoxLayout>
+
+// PNG sequences go to video at up to 120 fps. GIFs cap themselves at 50, players clamp
+// delays under 2 centiseconds.
+static const int kMaxFps = 120;
+static const int kMaxOutputSide = 8192;
+
+ExportSettingsDialog::ExportSettingsDialog(const ExportSettings &settings, const QSize &sceneSize, QWidget *parent)
+    : QDialog(parent), m_settings(settings)
+{
+    setWindowTitle("Export Settings");
+    setupUI(sceneSize);
+}
+
+void ExportSettingsDialog::setupUI(const QSize &sceneSize)
+{
+    auto *layout = new QVBoxLayout(this);
+
+    QGroupBox *outputGroup = new QGroupBox("Output");
+    auto *outputLayout = new QFormLayout(outputGroup);
+
+    m_fpsSpinBox = new QSpinBox;
+    m_fpsSpinBox->setRange(1, kMaxFps);
+    m_fpsSpinBox->setSuffix(" fps");
+    m_fpsSpinBox->setValue(m_settings.fps);
+    outputLayout->addRow("Frame rate:", m_fpsSpinBox);
+
+    // 0 follows the scene, with the other side set it keeps the scene's aspect
+    auto makeSideSpinBox = [&](int value, int sceneSide)
+    {
+        auto *spinBox = new QSpinBox;
+        spinBox->setRange(0, kMaxOutputSide);
+        spinBox->setSuffix(" px");
+        spinBox->setSpecialValueText(QString("Scene (%1 px)").arg(sceneSide));
+        spinBox->setValue(value);
+        return spinBox;
+    };
+    m_widthSpinBox = makeSideSpinBox(m_settings.width, sceneSize.width());
+    m_heightSpinBox = makeSideSpinBox(m_settings.height, sceneSize.height());
+    outputLayout->addRow("Width:", m_widthSpinBox);
+    outputLayout->addRow("Height:", m_heightSpinBox);
+
+    m_spreadDelaysCheckBox = new QCheckBox("Spread delay rounding over frames");
+    m_spreadDelaysCheckBox->setToolTip("Mix frame delays so the frame rate holds on average, instead of rounding every delay the same way");
+    m_spreadDelaysCheckBox->setChecked(m_settings.spreadDelays);
+    outputLayout->addRow(m_spreadDelaysCheckBox);
+    layout->addWidget(outputGroup);
+
+    QGroupBox *gifGroup = new QGroupBox("GIF");
+    auto *gifLayout = new QVBoxLayout(gifGroup);
+
+    m_localPalettesCheckBox = new QCheckBox("Local palettes");
+    m_localPalettesCheckBox->setToolTip("Quantize every GIF frame to its own palette instead of one shared palette");
+    m_localPalettesCheckBox->setChecked(m_settings.gifLocalPalettes);
+    gifLayout->addWidget(m_localPalettesCheckBox);
+
+    m_builtinLzwCheckBox = new QCheckBox("Built-in LZW encoder");
+    m_builtinLzwCheckBox->setToolTip("Compress GIF frames with the built-in LZW encoder instead of giflib's");
+    m_builtinLzwCheckBox->setChecked(m_settings.gifBuiltinLzw);
+    gifLayout->addWidget(m_builtinLzwCheckBox);
+    layout->addWidget(gifGroup);
+
+    QGroupBox *pngGroup = new QGroupBox("PNG Sequence and APNG");
+    auto *pngLayout = new QFormLayout(pngGroup);
+
+    m_pngLevelSpinBox = new QSpinBox;
+    m_pngLevelSpinBox->setRange(0, 9);
+    m_pngLevelSpinBox->setToolTip("zlib level: 0 stores frames uncompressed, 9 makes the smallest files");
+    m_pngLevelSpinBox->setValue(m_settings.pngCompressionLevel);
+    pngLayout->addRow("Compression level:", m_pngLevelSpinBox);
+
+    // In the order of ExportSettings::PngFilter
+    m_pngFilterCombo = new QComboBox;
+    m_pngFilterCombo->addItems({"Adaptive", "None", "Sub", "Up", "Average", "Paeth"});
+    m_pngFilterCombo->setToolTip("Row filter, a fixed one compresses faster than letting the encoder pick per row");
+    m_pngFilterCombo->setCurrentIndex(static_cast<int>(m_settings.pngFilter));
+    pngLayout->addRow("Filter:", m_pngFilterCombo);
+    layout->addWidget(pngGroup);
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttons);
+}
+
+ExportSettings ExportSettingsDialog::settings() const
+{
+    ExportSettings settings = m_settings;
+    settings.fps = m_fpsSpinBox->value();
+    settings.width = m_widthSpinBox->value();
+    settings.height = m_heightSpinBox->value();
+    settings.spreadDelays = m_spreadDelaysCheckBox->isChecked();
+    settings.gifLocalPalettes = m_localPalettesCheckBox->isChecked();
+    settings.gifBuiltinLzw = m_builtinLzwCheckBox->isChecked();
+    settings.pngCompressionLevel = m_pngLevelSpinBox->value();
+    settings.pngFilter = static_cast<ExportSettings::PngFilter>(m_pngFilterCombo->currentIndex());
+    return settings;
+}
@@ -0,0 +1,35 @@
+// Written by malekpour-dev.ir
+// ExportSettingsDialog edits the frame rate, output size, timing and GIF and PNG encoding
+// options every export uses.
+
+#pragma once
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDialog>
+#include <QSize>
+#include <QSpinBox>
+#include "ExportSettings.h"
+
+class ExportSettingsDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    // The scene size is shown for output sides left to follow the scene
+    ExportSettingsDialog(const ExportSettings &settings, const QSize &sceneSize, QWidget *parent = nullptr);
+
+    ExportSettings settings() const;
+
+private:
+    void setupUI(const QSize &sceneSize);
+
+    ExportSettings m_settings;
+    QSpinBox *m_fpsSpinBox = nullptr;
+    QSpinBox *m_widthSpinBox = nullptr;
+    QSpinBox *m_heightSpinBox = nullptr;
+    QCheckBox *m_spreadDelaysCheckBox = nullptr;
+    QCheckBox *m_localPalettesCheckBox = nullptr;
+    QCheckBox *m_builtinLzwCheckBox = nullptr;
+    QSpinBox *m_pngLevelSpinBox = nullptr;
+    QComboBox *m_pngFilterCombo = nullptr;
+};
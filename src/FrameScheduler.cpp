@@ -0,0 +1,102 @@
+// Written by malekpour-dev.ir
+// FrameScheduler is the single animation clock tick of the application. It only runs while
+// some visible canvas or preview has something moving, at the refresh rate of the screens involved.
+
+#include "FrameScheduler.h"
+#include <QCoreApplication>
+#include <QScreen>
+#include <algorithm>
+#include <cmath>
+
+// Used when no screen reports a usable refresh rate
+static const double kFallbackRefreshRate = 60.0;
+
+static double screenRefreshRate(const FrameClient *client)
+{
+    QScreen *screen = client->frameScreen();
+    return screen ? screen->refreshRate() : 0.0;
+}
+
+static int intervalFor(double refreshRate)
+{
+    if (refreshRate < 1.0)
+        refreshRate = kFallbackRefreshRate;
+    return std::max(1, static_cast<int>(std::floor(1000.0 / refreshRate)));
+}
+
+FrameScheduler &FrameScheduler::instance()
+{
+    // Owned by the application, so the timer is torn down with it on the GUI thread
+    static FrameScheduler *scheduler = new FrameScheduler(qApp);
+    return *scheduler;
+}
+
+FrameScheduler::FrameScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &FrameScheduler::tick);
+}
+
+void FrameScheduler::registerClient(FrameClient *client)
+{
+    if (!m_clients.contains(client))
+        m_clients.append(client);
+    wake();
+}
+
+void FrameScheduler::unregisterClient(FrameClient *client)
+{
+    m_clients.removeAll(client);
+}
+
+void FrameScheduler::wake()
+{
+    if (m_timer.isActive())
+        return;
+
+    // The fastest screen showing an animated client sets the pace
+    double refreshRate = 0.0;
+    bool needed = false;
+    for (const FrameClient *client : m_clients)
+    {
+        if (client->wantsFrames())
+        {
+            needed = true;
+            refreshRate = std::max(refreshRate, screenRefreshRate(client));
+        }
+    }
+
+    if (needed)
+        m_timer.start(intervalFor(refreshRate));
+}
+
+void FrameScheduler::tick()
+{
+    // A copy, a client may register or unregister another one while it advances
+    const QVector<FrameClient *> clients = m_clients;
+
+    double refreshRate = 0.0;
+    bool needed = false;
+    for (FrameClient *client : clients)
+    {
+        if (client->wantsFrames())
+        {
+            client->advanceFrame();
+            needed = true;
+            refreshRate = std::max(refreshRate, screenRefreshRate(client));
+        }
+    }
+
+    // Nothing moves anywhere: no more wakeups until a client calls wake()
+    if (!needed)
+    {
+        m_timer.stop();
+        return;
+    }
+
+    // Follows windows moved to a screen with another refresh rate
+    int interval = intervalFor(refreshRate);
+    if (interval != m_timer.interval())
+        m_timer.setInterval(interval);
+}
@@ -0,0 +1,52 @@
+// Written by malekpour-dev.ir
+// FrameScheduler is the single animation clock tick of the application. It only runs while
+// some visible canvas or preview has something moving, at the refresh rate of the screens involved.
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+class QScreen;
+
+// Anything animated the scheduler advances: editor canvases, template previews. Clients
+// unregister themselves before they are destroyed.
+class FrameClient
+{
+public:
+    virtual ~FrameClient() = default;
+
+    // Playing, on screen and with something that moves
+    virtual bool wantsFrames() const = 0;
+    virtual void advanceFrame() = 0;
+
+    // Screen whose refresh rate paces the ticks, null when unknown
+    virtual QScreen *frameScreen() const = 0;
+};
+
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FrameScheduler &instance();
+
+    void registerClient(FrameClient *client);
+    void unregisterClient(FrameClient *client);
+
+    // Re-checks whether frames are needed, e.g. after playing, showing or editing a canvas.
+    // Cheap when the scheduler is already running.
+    void wake();
+
+    bool isRunning() const { return m_timer.isActive(); }
+
+private slots:
+    void tick();
+
+private:
+    explicit FrameScheduler(QObject *parent = nullptr);
+
+    QTimer m_timer;
+    QVector<FrameClient *> m_clients;
+};
@@ -2,11 +2,31 @@
 // MainWindow is a QWidget-based class responsible for setting up the main window, its components, and their connections.
 
 #include "MainWindow.h"
+#include "ExportSettingsDialog.h"
+#include <QBuffer>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <png.h>
+#include <zlib.h>
+#include "ApngDeltaEncoder.h"
+#include "FramePipeline.h"
+#include "GifDeltaEncoder.h"
+#include "GifLzwEncoder.h"
+#include "LoopTiming.h"
+#include "PaletteQuantizer.h"
 
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), m_mainSplitter(nullptr), m_controlPanel(nullptr), m_fpsTimer(new QTimer(this)),
-      m_animationTimer(new QTimer(this)), m_frameCount(0), m_currentColor(Qt::blue), m_isAnimating(true),
+      m_frameCount(0), m_currentColor(Qt::blue), m_isAnimating(true),
       m_selectedItemId(-1), m_updatingControls(false)
 {
     setWindowTitle("twiq");
@@ -16,15 +36,13 @@ MainWindow::MainWindow(QWidget *parent)
     setupToolBar();
     connectSignals();
 
-    // Initialize FPS counter
+    // FPS counter, it only runs while the canvas produces frames
     m_fpsTimer->setInterval(1000);
     connect(m_fpsTimer, &QTimer::timeout, this, &MainWindow::updateFrameRate);
-    m_fpsTimer->start();
 
-    // Initialize animation timer
-    m_animationTimer->setInterval(16); // ~60 FPS
-    connect(m_animationTimer, &QTimer::timeout, this, &MainWindow::updateAnimation);
-    m_animationTimer->start();
+    // Frames come from the shared FrameScheduler, which idles while nothing moves
+    connect(m_canvas, &CanvasWidget::frameAdvanced, this, &MainWindow::onCanvasFrameAdvanced);
+    m_canvas->setAnimating(m_isAnimating);
 
     statusBar()->showMessage("Ready - Click 'Add Spinner' to create your first spinner");
 
@@ -57,6 +75,7 @@ void MainWindow::setupMenuBar()
 
     QMenu *fileMenu = menuBar->addMenu("&File");
     fileMenu->addAction("&Export Animation...", this, &MainWindow::onExportClicked, QKeySequence::SaveAs);
+    fileMenu->addAction("Export &Settings...", this, &MainWindow::onExportSettingsClicked);
     fileMenu->addSeparator();
     fileMenu->addAction("E&xit", QKeySequence::Quit, this, &QWidget::close);
 
@@ -67,6 +86,7 @@ void MainWindow::setupMenuBar()
 
     QMenu *animMenu = menuBar->addMenu("&Animation");
     animMenu->addAction("&Start/Stop", QKeySequence("Space"), this, &MainWindow::onStartStopClicked);
+    animMenu->addAction("Render &Threads...", this, &MainWindow::onRenderThreadsClicked);
 
     QMenu *helpMenu = menuBar->addMenu("&Help");
     helpMenu->addAction("&About", [this]()
@@ -429,245 +449,705 @@ void MainWindow::onStartStopClicked()
     statusBar()->showMessage(m_isAnimating ? "Animation playing" : "Animation paused");
 }
 
-QImage MainWindow::captureFrame()
+void MainWindow::onRenderThreadsClicked()
+{
+    bool ok;
+    int threads = QInputDialog::getInt(this, "Render Threads",
+                                       "Blend2D render threads (0 = auto, 1 = single-threaded):",
+                                       m_renderer.threadCount(), 0, 64, 1, &ok);
+    if (!ok)
+        return;
+
+    // The live canvas and the exporter share the same setting
+    m_renderer.setThreadCount(threads);
+    m_canvas->setRenderThreadCount(threads);
+
+    statusBar()->showMessage(QString("Render mode: %1")
+                                 .arg(m_renderer.threadingDescription(m_canvas->width(), m_canvas->height())));
+}
+
+void MainWindow::captureFrame(const Scene &scene, double time, const QSize &size, SceneRenderer &renderer, QImage &target)
 {
-    // Create an image with transparent background for export
-    QImage image(m_canvas->size(), QImage::Format_ARGB32);
-    image.fill(Qt::transparent);
+    // Premultiplied to match BL_FORMAT_PRGB32, the renderer clears it to transparent and
+    // scales the scene to it. A target of the right size is reused whatever it was converted to since.
+    if (target.size() != size || target.depth() != 32)
+        target = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    else
+        target.reinterpretAsFormat(QImage::Format_ARGB32_Premultiplied);
 
     BLImage blImage;
     blImage.createFromData(
-        image.width(),
-        image.height(),
+        target.width(),
+        target.height(),
         BL_FORMAT_PRGB32,
-        image.bits(),
-        image.bytesPerLine(),
+        target.bits(),
+        target.bytesPerLine(),
         BL_DATA_ACCESS_RW,
         nullptr,
         nullptr);
 
-    BLContext ctx(blImage);
-    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
-    ctx.clearAll();
-
     // Draw all spinners
-    for (const auto &item : m_canvas->getItems())
+    renderer.render(scene, time, blImage);
+}
+
+// Pipeline slot of the GIF exporter, the canvas buffer is reused from frame to frame
+struct GifFrame
+{
+    QImage canvas;
+    QImage indexed;
+};
+
+// Pipeline slot of the PNG sequence exporter, the canvas is compressed straight from its rows
+struct PngFrame
+{
+    QImage canvas;
+    bool written = false;
+};
+
+// Frames the global palette is sampled from, spread over the animation
+static const int kPaletteSampleFrames = 32;
+
+// Pixels sampled per frame, larger frames are sampled on a coarser grid
+static const int kPaletteSamplesPerFrame = 65536;
+
+// GIF color maps hold a power of two entries, unused ones stay black
+static ColorMapObject *makeColorMap(const QVector<QRgb> &palette)
+{
+    int size = 2;
+    while (size < palette.size())
     {
-        if (!item)
-            continue;
-        m_canvas->drawSpinner(ctx, *item);
+        size <<= 1;
     }
 
-    ctx.end();
-
-    image = image.copy();
-    return image;
+    ColorMapObject *colorMap = GifMakeMapObject(size, nullptr);
+    for (int i = 0; i < size; ++i)
+    {
+        QRgb color = i < palette.size() ? palette[i] : 0;
+        colorMap->Colors[i].Red = qRed(color);
+        colorMap->Colors[i].Green = qGreen(color);
+        colorMap->Colors[i].Blue = qBlue(color);
+    }
+    return colorMap;
 }
 
-bool MainWindow::exportGif(const QString &fileName, QProgressDialog &progress)
+int MainWindow::exportWorkerCount(int frameCount) const
 {
-    // Use the canvas's animation FPS and duration, not the current frameCount
-    double duration = m_canvas->getAnimationDuration();
-    if (duration <= 0.0)
-        duration = 1.0; // fallback to 1 second if not set
+    // The render thread setting decides how many frames run at once
+    int workerCount = m_renderer.threadCount() > 0 ? m_renderer.threadCount() : QThread::idealThreadCount();
+    return std::max(1, std::min(workerCount, frameCount));
+}
 
-    int fps = m_frameCount;
-    if (fps <= 0)
-        fps = 60; // fallback to 60 FPS
+static void pngWrite(png_structp png, png_bytep data, png_size_t length)
+{
+    auto *device = static_cast<QIODevice *>(png_get_io_ptr(png));
+    if (device->write(reinterpret_cast<const char *>(data), static_cast<qint64>(length)) != static_cast<qint64>(length))
+        png_error(png, "write failed");
+}
 
-    // Calculate total frames based on duration and FPS
-    int totalFrames = static_cast<int>(duration * fps);
-    if (totalFrames <= 0)
-        totalFrames = 60; // fallback to 60 frames
+static void pngFlush(png_structp)
+{
+}
 
-    const int width = m_canvas->width();
-    const int height = m_canvas->height();
-    const char *filename = fileName.toUtf8().constData();
+static int pngFilterFlags(ExportSettings::PngFilter filter)
+{
+    switch (filter)
+    {
+    case ExportSettings::PngFilter::None:
+        return PNG_FILTER_NONE;
+    case ExportSettings::PngFilter::Sub:
+        return PNG_FILTER_SUB;
+    case ExportSettings::PngFilter::Up:
+        return PNG_FILTER_UP;
+    case ExportSettings::PngFilter::Average:
+        return PNG_FILTER_AVG;
+    case ExportSettings::PngFilter::Paeth:
+        return PNG_FILTER_PAETH;
+    case ExportSettings::PngFilter::Adaptive:
+        break;
+    }
+    return PNG_ALL_FILTERS;
+}
 
-    int error;
-    GifFileType *gif = EGifOpenFileName(filename, false, &error);
-    if (!gif)
+// Writes an ARGB32 image as 8 bit RGBA, rows go to libpng straight from the image. libpng
+// reorders the channels in its own row buffer, the image is never copied or touched.
+static bool writePng(const QImage &image, QIODevice &device, int level, ExportSettings::PngFilter filter)
+{
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!png)
+        return false;
+    png_infop info = png_create_info_struct(png);
+    if (!info)
     {
-        qDebug() << "Error opening GIF: " << GifErrorString(error);
+        png_destroy_write_struct(&png, nullptr);
+        return false;
+    }
+    if (setjmp(png_jmpbuf(png)))
+    {
+        png_destroy_write_struct(&png, &info);
         return false;
     }
 
-    QVector<QImage> frames;
-    frames.reserve(totalFrames);
-    double dt = duration / totalFrames;
+    png_set_write_fn(png, &device, pngWrite, pngFlush);
+    png_set_compression_level(png, level);
+    png_set_filter(png, PNG_FILTER_TYPE_BASE, pngFilterFlags(filter));
+    png_set_IHDR(png, info, image.width(), image.height(), 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+    png_write_info(png, info);
+
+    // ARGB32 pixels are 32 bit words: B, G, R, A in memory on little endian machines
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    png_set_bgr(png);
+#else
+    png_set_swap_alpha(png);
+#endif
+
+    for (int y = 0; y < image.height(); ++y)
+    {
+        png_write_row(png, const_cast<png_bytep>(image.constScanLine(y)));
+    }
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+    return true;
+}
 
-    // Save original animation state and time
-    bool wasAnimating = m_isAnimating;
-    double originalTime = duration / totalFrames;
-    m_canvas->setAnimating(false);
+bool MainWindow::exportPngSequence(const QString &fileName, QProgressDialog &progress)
+{
+    const ExportSettings settings = m_exportSettings;
+    const Scene scene = m_canvas->scene();
+    const QSize outputSize = settings.outputSize(scene);
+
+    // Video tools import sequences at a fixed rate, so frames sit exactly at k / fps over
+    // the shortest loop of whole frames
+    const int totalFrames = LoopTiming::frameCountAt(scene, settings.fps);
+
+    // name.png becomes name_0000.png, name_0001.png, ... The number is appended, not
+    // substituted, so a name that itself contains %1 stays as it is.
+    QFileInfo info(fileName);
+    const QString baseName = info.dir().filePath(info.completeBaseName() + "_");
+    const int digits = std::max(4, static_cast<int>(QString::number(totalFrames - 1).size()));
+    auto framePath = [&](int frame)
+    {
+        return baseName + QString("%1.png").arg(frame, digits, 10, QChar('0'));
+    };
 
-    // Render each frame at correct time
-    QVector<QVector<QRgb>> framePalettes;
-    for (int i = 0; i < totalFrames; ++i)
+    const int workerCount = exportWorkerCount(totalFrames);
+    std::vector<SceneRenderer> renderers(workerCount);
+    for (auto &renderer : renderers)
     {
-        double t = i * dt;
-        m_canvas->setAnimationTime(t);
-        QImage frame = captureFrame().convertToFormat(QImage::Format_ARGB32);
+        renderer.setThreadCount(1);
+    }
 
-        // Convert to 8-bit with optimal palette and dithering, preserving transparency
-        QImage quantized = frame.convertToFormat(
-            QImage::Format_Indexed8,
-            Qt::DiffuseDither | Qt::ThresholdAlphaDither | Qt::PreferDither);
+    // Frames are rendered and compressed on the workers, each straight into its own file.
+    // Only progress is reported in order.
+    FramePipeline<PngFrame> pipeline(totalFrames, workerCount, workerCount * 2);
+    bool finished = pipeline.run(
+        [&](int frame, int worker, PngFrame &result)
+        {
+            captureFrame(scene, static_cast<double>(frame) / settings.fps, outputSize, renderers[worker], result.canvas);
+
+            // PNG stores straight alpha, converted in place in the render buffer
+            result.canvas.convertTo(QImage::Format_ARGB32);
 
-        QVector<QRgb> palette = quantized.colorTable();
-        int transparentIndex = -1;
-        for (int j = 0; j < palette.size(); ++j)
+            QSaveFile file(framePath(frame));
+            result.written = file.open(QIODevice::WriteOnly) &&
+                             writePng(result.canvas, file, settings.pngCompressionLevel, settings.pngFilter) &&
+                             file.commit();
+        },
+        [&](int frame, PngFrame &result)
         {
-            if (qAlpha(palette[j]) == 0)
+            if (!result.written)
             {
-                transparentIndex = j;
-                break;
+                qDebug() << "Error writing PNG frame" << framePath(frame);
+                return false;
             }
+
+            progress.setValue(static_cast<int>((frame + 1) * 100.0 / totalFrames));
+            return true;
+        },
+        [&]()
+        {
+            QApplication::processEvents();
+            return !progress.wasCanceled();
+        });
+
+    if (!finished)
+        return false;
+
+    progress.setValue(100);
+    qDebug() << "PNG sequence created: " << totalFrames << "frames at" << settings.fps << "fps";
+    return true;
+}
+
+// Pipeline slot of the APNG exporter, its buffer is swapped with the delta encoder's reference
+struct ApngFrame
+{
+    QImage canvas;
+};
+
+// Longest wait for a compressed APNG frame before events are processed again
+static const int kCompressPollMs = 50;
+
+// An APNG frame compressed on the thread pool, written in order once it is done
+struct ApngChunk
+{
+    ApngDeltaFrame frame;
+    QByteArray data; // zlib stream of the frame's rows, empty when compression failed
+    QSemaphore done;
+};
+
+static void appendUint32(QByteArray &out, quint32 value)
+{
+    char bytes[4];
+    qToBigEndian(value, bytes);
+    out.append(bytes, 4);
+}
+
+static void appendUint16(QByteArray &out, quint16 value)
+{
+    char bytes[2];
+    qToBigEndian(value, bytes);
+    out.append(bytes, 2);
+}
+
+// Length, type, data and the CRC of type and data
+static bool writePngChunk(QIODevice &device, const char *type, const QByteArray &data, const QByteArray &tail = QByteArray())
+{
+    QByteArray header;
+    appendUint32(header, static_cast<quint32>(data.size() + tail.size()));
+    header.append(type, 4);
+
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef *>(type), 4);
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(data.constData()), static_cast<uInt>(data.size()));
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(tail.constData()), static_cast<uInt>(tail.size()));
+    QByteArray footer;
+    appendUint32(footer, static_cast<quint32>(crc));
+
+    return device.write(header) == header.size() && device.write(data) == data.size() &&
+           device.write(tail) == tail.size() && device.write(footer) == footer.size();
+}
+
+// The zlib stream libpng makes of an image: the data of its IDAT chunks, which APNG frames
+// carry as they are
+static QByteArray pngImageData(const QImage &image, int level, ExportSettings::PngFilter filter)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    if (!writePng(image, buffer, level, filter))
+        return QByteArray();
+
+    // Chunks follow the 8 byte signature: length, type, data, CRC
+    const QByteArray &png = buffer.data();
+    QByteArray data;
+    for (qsizetype at = 8; at + 12 <= png.size();)
+    {
+        qsizetype length = qFromBigEndian<quint32>(png.constData() + at);
+        if (png.mid(at + 4, 4) == "IDAT")
+            data.append(png.constData() + at + 8, length);
+        at += length + 12;
+    }
+    return data;
+}
+
+bool MainWindow::exportApng(const QString &fileName, QProgressDialog &progress)
+{
+    const ExportSettings settings = m_exportSettings;
+    const Scene scene = m_canvas->scene();
+    const QSize outputSize = settings.outputSize(scene);
+    const int width = outputSize.width();
+    const int height = outputSize.height();
+
+    // APNG delays are fractions of a second, so frames sit exactly at k / fps
+    const int totalFrames = LoopTiming::frameCountAt(scene, settings.fps);
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Error opening APNG: " << file.errorString();
+        return false;
+    }
+
+    // 8 bit RGBA, the full alpha GIF cannot keep, then default compression, filter and no interlace
+    const char imageFormat[] = {8, 6, 0, 0, 0};
+    QByteArray header;
+    appendUint32(header, width);
+    appendUint32(header, height);
+    header.append(imageFormat, sizeof(imageFormat));
+
+    // The frame count is patched in once identical frames were merged
+    QByteArray animationControl;
+    appendUint32(animationControl, totalFrames);
+    appendUint32(animationControl, 0); // Loop forever
+
+    file.write("\x89PNG\r\n\x1a\n", 8);
+    if (!writePngChunk(file, "IHDR", header))
+        return false;
+    const qint64 animationControlAt = file.pos();
+    if (!writePngChunk(file, "acTL", animationControl))
+        return false;
+
+    // Rendering and compressing a frame cost about the same, so the pipeline's render
+    // workers and the compressor share one thread budget instead of each taking all of it
+    const int threadBudget = exportWorkerCount(totalFrames);
+    const int workerCount = std::max(1, threadBudget / 2);
+    const int compressorCount = std::max(1, threadBudget - workerCount);
+    std::vector<SceneRenderer> renderers(workerCount);
+    for (auto &renderer : renderers)
+    {
+        renderer.setThreadCount(1);
+    }
+    const int window = workerCount * 2;
+    const int compressWindow = compressorCount * 2;
+
+    auto poll = [&]()
+    {
+        QApplication::processEvents();
+        return !progress.wasCanceled();
+    };
+
+    // Frames are diffed in order, compressing the changed rectangles runs on the pool
+    QThreadPool compressor;
+    compressor.setMaxThreadCount(compressorCount);
+    std::deque<std::shared_ptr<ApngChunk>> compressing;
+    quint32 sequence = 0;
+    int framesWritten = 0;
+
+    // Waits for the oldest frame in compression and writes its control and data chunks
+    auto writeOldest = [&]()
+    {
+        std::shared_ptr<ApngChunk> chunk = compressing.front();
+        while (!chunk->done.tryAcquire(1, kCompressPollMs))
+        {
+            if (!poll())
+                return false;
         }
-        if (transparentIndex == -1)
+        compressing.pop_front();
+        if (chunk->data.isEmpty())
+            return false;
+
+        const ApngDeltaFrame &frame = chunk->frame;
+        QByteArray control;
+        appendUint32(control, sequence++);
+        appendUint32(control, frame.rect.width());
+        appendUint32(control, frame.rect.height());
+        appendUint32(control, frame.rect.x());
+        appendUint32(control, frame.rect.y());
+        appendUint16(control, static_cast<quint16>(frame.delay));
+        appendUint16(control, static_cast<quint16>(settings.fps));
+        // Never disposed of, a frame that has to clear pixels replaces its rectangle instead
+        control.append(char(0));                       // APNG_DISPOSE_OP_NONE
+        control.append(char(frame.blendOver ? 1 : 0)); // APNG_BLEND_OP_OVER or APNG_BLEND_OP_SOURCE
+        if (!writePngChunk(file, "fcTL", control))
+            return false;
+
+        // The first frame is the default image every PNG decoder shows, the rest are frame data
+        bool written;
+        if (framesWritten == 0)
         {
-            // Add transparent color if not present
-            palette.insert(0, qRgba(0, 0, 0, 0));
-            transparentIndex = 0;
-            quantized.setColorTable(palette);
+            written = writePngChunk(file, "IDAT", chunk->data);
         }
-        else if (transparentIndex != 0)
+        else
         {
-            // Move transparent color to index 0
-            QRgb transparentColor = palette[transparentIndex];
-            palette.removeAt(transparentIndex);
-            palette.insert(0, transparentColor);
-
-            for (int y = 0; y < quantized.height(); ++y)
-            {
-                uchar *scan = quantized.scanLine(y);
-                for (int x = 0; x < quantized.width(); ++x)
-                {
-                    if (scan[x] == transparentIndex)
-                        scan[x] = 0;
-                    else if (scan[x] < transparentIndex)
-                        scan[x] += 1;
-                }
-            }
-            quantized.setColorTable(palette);
-            transparentIndex = 0;
+            QByteArray frameSequence;
+            appendUint32(frameSequence, sequence++);
+            written = writePngChunk(file, "fdAT", frameSequence, chunk->data);
         }
+        ++framesWritten;
+        return written;
+    };
 
-        for (int y = 0; y < quantized.height(); ++y)
+    auto compress = [&](ApngDeltaFrame &frame)
+    {
+        auto chunk = std::make_shared<ApngChunk>();
+        chunk->frame = std::move(frame);
+        compressor.start([chunk, level = settings.pngCompressionLevel, filter = settings.pngFilter]()
+                         {
+            chunk->data = pngImageData(chunk->frame.pixels, level, filter);
+            chunk->done.release(); });
+        compressing.push_back(chunk);
+
+        // A bounded number of frames waits for the file, memory stays flat
+        while (static_cast<int>(compressing.size()) > compressWindow)
         {
-            uchar *scan = quantized.scanLine(y);
-            for (int x = 0; x < quantized.width(); ++x)
-            {
-                if (qAlpha(palette[scan[x]]) < 128)
-                {
-                    scan[x] = transparentIndex;
-                }
-            }
+            if (!writeOldest())
+                return false;
         }
+        return true;
+    };
 
-        frames.append(quantized);
-        framePalettes.append(palette);
+    ApngDeltaEncoder deltaEncoder(width, height);
+    ApngDeltaFrame delta;
 
-        // Set progress value for rendering frames
-        progress.setValue(static_cast<int>((i + 1) * 50.0 / totalFrames));
-        QApplication::processEvents();
-        if (progress.wasCanceled())
+    FramePipeline<ApngFrame> pipeline(totalFrames, workerCount, window);
+    bool finished = pipeline.run(
+        [&](int frame, int worker, ApngFrame &result)
         {
-            EGifCloseFile(gif, &error);
-            return false;
-        }
-    }
+            captureFrame(scene, static_cast<double>(frame) / settings.fps, outputSize, renderers[worker], result.canvas);
 
-    m_canvas->setAnimationTime(originalTime);
-    m_canvas->setAnimating(wasAnimating);
+            // PNG stores straight alpha
+            result.canvas.convertTo(QImage::Format_ARGB32);
+        },
+        [&](int frame, ApngFrame &result)
+        {
+            // A frame is compressed once the next one shows it did not just stay up longer
+            if (deltaEncoder.addFrame(result.canvas, 1, delta) && !compress(delta))
+                return false;
 
-    QVector<QRgb> globalColorTable = frames[0].colorTable();
-    int colorCount = globalColorTable.size();
-    if (colorCount > 256)
-        colorCount = 256;
+            progress.setValue(static_cast<int>((frame + 1) * 100.0 / totalFrames));
+            return true;
+        },
+        poll);
 
-    ColorMapObject *colorMap = GifMakeMapObject(colorCount, nullptr);
-    for (int i = 0; i < colorCount; ++i)
+    if (finished && deltaEncoder.finish(delta))
+        finished = compress(delta);
+    while (finished && !compressing.empty())
     {
-        colorMap->Colors[i].Red = qRed(globalColorTable[i]);
-        colorMap->Colors[i].Green = qGreen(globalColorTable[i]);
-        colorMap->Colors[i].Blue = qBlue(globalColorTable[i]);
+        finished = writeOldest();
     }
 
-    if (EGifPutScreenDesc(gif, width, height, colorCount, 0, colorMap) == GIF_ERROR)
+    if (!finished)
     {
-        qDebug() << "Error writing screen desc";
-        EGifCloseFile(gif, &error);
-        GifFreeMapObject(colorMap);
+        // Uncommitted, the file is left as it was
+        compressor.clear();
+        compressor.waitForDone();
         return false;
     }
 
-    // Write each frame, and loop forever
-    // Add Netscape Application Extension for infinite looping
-    unsigned char netscapeExt[] = {1, 0, 0};
-    if (EGifPutExtensionLeader(gif, APPLICATION_EXT_FUNC_CODE) == GIF_ERROR ||
-        EGifPutExtensionBlock(gif, 11, "NETSCAPE2.0") == GIF_ERROR ||
-        EGifPutExtensionBlock(gif, sizeof(netscapeExt), netscapeExt) == GIF_ERROR ||
-        EGifPutExtensionTrailer(gif) == GIF_ERROR)
+    animationControl.clear();
+    appendUint32(animationControl, framesWritten);
+    appendUint32(animationControl, 0);
+    if (!writePngChunk(file, "IEND", QByteArray()) || !file.seek(animationControlAt) ||
+        !writePngChunk(file, "acTL", animationControl) || !file.commit())
     {
-        EGifCloseFile(gif, &error);
-        GifFreeMapObject(colorMap);
+        qDebug() << "Error writing APNG: " << file.errorString();
         return false;
     }
 
-    int frameDelay = static_cast<int>(100.0 / fps); 
-    int transparentIndex = 0;                      
+    progress.setValue(100);
+    qDebug() << "APNG created: " << framesWritten << "frames at" << settings.fps << "fps";
+    return true;
+}
+
+bool MainWindow::exportGif(const QString &fileName, QProgressDialog &progress)
+{
+    // Everything comes from the export settings, never from the editor's frame counter or
+    // window, so the same scene always exports the same file
+    const ExportSettings settings = m_exportSettings;
+    const QSize outputSize = settings.outputSize(m_canvas->scene());
+    const int width = outputSize.width();
+    const int height = outputSize.height();
+
+    // The true common period of all items at their speeds, in as few frames as reproduce it
+    // on GIF's centisecond clock, so the loop has no seam
+    const LoopTiming timing = LoopTiming::forScene(m_canvas->scene(), settings.fps, settings.spreadDelays);
+    const int totalFrames = timing.frameCount;
+    if (!timing.seamless)
+        qDebug() << "No common loop period, exporting" << timing.duration() << "seconds with a seam";
+
+    const char *filename = fileName.toUtf8().constData();
 
-    for (int i = 0; i < frames.size(); ++i)
+    int error;
+    GifFileType *gif = EGifOpenFileName(filename, false, &error);
+    if (!gif)
     {
-        const QImage &img = frames[i];
+        qDebug() << "Error opening GIF: " << GifErrorString(error);
+        return false;
+    }
 
-        unsigned char gce[4] = {0x09, static_cast<unsigned char>(frameDelay), static_cast<unsigned char>(transparentIndex), 0};
-        if (EGifPutExtension(gif, GRAPHICS_EXT_FUNC_CODE, 4, gce) == GIF_ERROR)
+    // Workers render from their own copy of the scene, the live canvas keeps animating and
+    // may be edited meanwhile. The render thread setting decides how many frames run at once.
+    const Scene scene = m_canvas->scene();
+    const int workerCount = exportWorkerCount(totalFrames);
+
+    // One renderer per worker, so BLContexts and shape caches are never shared. Frames run
+    // in parallel, a frame itself is rasterized single-threaded.
+    std::vector<SceneRenderer> renderers(workerCount);
+    for (auto &renderer : renderers)
+    {
+        renderer.setThreadCount(1);
+    }
+
+    // Two frames in flight per worker keep every core busy while the encoder writes, and
+    // bound memory no matter how long the animation is
+    const int window = workerCount * 2;
+
+    auto poll = [&]()
+    {
+        QApplication::processEvents();
+        return !progress.wasCanceled();
+    };
+
+    // One palette for the whole animation, from pixel statistics of frames spread over it,
+    // so every frame indexes the same global color map
+    const bool localPalettes = settings.gifLocalPalettes;
+    PaletteMap globalPalette;
+    if (!localPalettes)
+    {
+        PaletteQuantizer quantizer;
+        int sampleFrames = std::min(totalFrames, kPaletteSampleFrames);
+        double pixelsPerSample = static_cast<double>(width) * height / kPaletteSamplesPerFrame;
+        int step = std::max(1, static_cast<int>(std::sqrt(pixelsPerSample)));
+
+        FramePipeline<QImage> sampler(sampleFrames, workerCount, window);
+        bool sampled = sampler.run(
+            [&](int sample, int worker, QImage &canvas)
+            {
+                int frame = sample * totalFrames / sampleFrames;
+                captureFrame(scene, timing.frameTime(frame), outputSize, renderers[worker], canvas);
+                canvas.convertTo(QImage::Format_ARGB32);
+            },
+            [&](int, QImage &canvas)
+            {
+                quantizer.addFrame(canvas, step);
+                return true;
+            },
+            poll);
+        if (!sampled)
         {
             EGifCloseFile(gif, &error);
-            GifFreeMapObject(colorMap);
             return false;
         }
 
-        if (EGifPutImageDesc(gif, 0, 0, width, height, false, nullptr) == GIF_ERROR)
+        globalPalette = PaletteMap(quantizer.palette());
+    }
+
+    FramePipeline<GifFrame> pipeline(totalFrames, workerCount, window);
+
+    ColorMapObject *colorMap = nullptr;
+
+    // Frames are stored as the rectangle that changed since the previous one
+    GifDeltaEncoder deltaEncoder(width, height);
+    GifDeltaFrame delta;
+
+    // The built-in encoder compresses a whole frame at once, giflib goes line by line
+    const bool builtinLzw = settings.gifBuiltinLzw;
+    GifLzwEncoder lzwEncoder;
+    std::vector<uint8_t> lzwData;
+
+    auto writeFrame = [&](const GifDeltaFrame &frame)
+    {
+        // Packed byte: disposal method in bits 2-4, transparent color flag in bit 0. Index 0
+        // is the transparent color of every palette.
+        unsigned char gce[4] = {static_cast<unsigned char>((frame.disposal << 2) | 1),
+                                static_cast<unsigned char>(frame.delay & 0xFF),
+                                static_cast<unsigned char>(frame.delay >> 8), 0};
+        if (EGifPutExtension(gif, GRAPHICS_EXT_FUNC_CODE, 4, gce) == GIF_ERROR)
+            return false;
+
+        // giflib keeps its own copy of a local color map
+        const QRect &rect = frame.rect;
+        ColorMapObject *localMap = localPalettes ? makeColorMap(frame.palette) : nullptr;
+        bool described = EGifPutImageDesc(gif, rect.x(), rect.y(), rect.width(), rect.height(), false, localMap) != GIF_ERROR;
+
+        // giflib has already written the minimum code size byte, from the bits of the map
+        int codeSize = std::max(2, (localMap ? localMap : colorMap)->BitsPerPixel);
+        if (localMap)
+            GifFreeMapObject(localMap);
+        if (!described)
         {
             qDebug() << "Error writing image desc";
-            EGifCloseFile(gif, &error);
-            GifFreeMapObject(colorMap);
             return false;
         }
-        
-        for (int y = 0; y < height; ++y)
+
+        if (builtinLzw)
+        {
+            lzwData.resize(GifLzwEncoder::maxEncodedSize(frame.pixels.size()));
+            lzwEncoder.encode(frame.pixels.data(), frame.pixels.size(), codeSize, lzwData.data());
+
+            // Data sub-blocks go out as they are, then the terminator
+            for (size_t at = 0; lzwData[at] != 0; at += lzwData[at] + 1)
+            {
+                if (EGifPutCodeNext(gif, lzwData.data() + at) == GIF_ERROR)
+                    return false;
+            }
+            return EGifPutCodeNext(gif, nullptr) != GIF_ERROR;
+        }
+
+        for (int y = 0; y < rect.height(); ++y)
         {
-            const uchar *scan = img.scanLine(y);
-            if (EGifPutLine(gif, const_cast<GifByteType *>(scan), width) == GIF_ERROR)
+            const uint8_t *scan = frame.pixels.data() + static_cast<size_t>(y) * rect.width();
+            if (EGifPutLine(gif, const_cast<GifByteType *>(scan), rect.width()) == GIF_ERROR)
             {
                 qDebug() << "Error writing GIF line";
-                EGifCloseFile(gif, &error);
-                GifFreeMapObject(colorMap);
                 return false;
             }
         }
+        return true;
+    };
 
-        // Set progress value for writing frames
-        progress.setValue(50 + static_cast<int>((i + 1) * 50.0 / frames.size()));
-        QApplication::processEvents();
-        if (progress.wasCanceled())
+    bool finished = pipeline.run(
+        [&](int frame, int worker, GifFrame &result)
         {
-            EGifCloseFile(gif, &error);
+            captureFrame(scene, timing.frameTime(frame), outputSize, renderers[worker], result.canvas);
+            result.canvas.convertTo(QImage::Format_ARGB32);
+
+            if (localPalettes)
+            {
+                // Frames that differ a lot get their own palette, at the cost of a cube per frame
+                PaletteQuantizer quantizer;
+                quantizer.addFrame(result.canvas);
+                PaletteMap(quantizer.palette()).map(result.canvas, result.indexed);
+            }
+            else
+            {
+                globalPalette.map(result.canvas, result.indexed);
+            }
+        },
+        [&](int frame, GifFrame &result)
+        {
+            if (frame == 0)
+            {
+                // Without a global palette every frame carries a local color map
+                if (!localPalettes)
+                    colorMap = makeColorMap(globalPalette.palette());
+
+                if (EGifPutScreenDesc(gif, width, height, 8, 0, colorMap) == GIF_ERROR)
+                {
+                    qDebug() << "Error writing screen desc";
+                    return false;
+                }
+
+                // Add Netscape Application Extension for infinite looping
+                unsigned char netscapeExt[] = {1, 0, 0};
+                if (EGifPutExtensionLeader(gif, APPLICATION_EXT_FUNC_CODE) == GIF_ERROR ||
+                    EGifPutExtensionBlock(gif, 11, "NETSCAPE2.0") == GIF_ERROR ||
+                    EGifPutExtensionBlock(gif, sizeof(netscapeExt), netscapeExt) == GIF_ERROR ||
+                    EGifPutExtensionTrailer(gif) == GIF_ERROR)
+                {
+                    return false;
+                }
+            }
+
+            // A frame is written once the next one decides its disposal, one frame behind
+            if (deltaEncoder.addFrame(result.indexed, timing.frameDelay(frame), delta) && !writeFrame(delta))
+                return false;
+
+            // Frames reach the file as soon as they are ready, progress follows the writer
+            progress.setValue(static_cast<int>((frame + 1) * 100.0 / totalFrames));
+            return true;
+        },
+        poll);
+
+    // The last frame clears the screen again for the next loop
+    if (finished && deltaEncoder.finish(delta))
+        finished = writeFrame(delta);
+
+    if (!finished)
+    {
+        EGifCloseFile(gif, &error);
+        if (colorMap)
             GifFreeMapObject(colorMap);
-            return false;
-        }
+        return false;
     }
 
     if (EGifCloseFile(gif, &error) == GIF_ERROR)
     {
         qDebug() << "Error closing GIF file: " << GifErrorString(error);
-        GifFreeMapObject(colorMap);
+        if (colorMap)
+            GifFreeMapObject(colorMap);
         return false;
     }
-    GifFreeMapObject(colorMap);
+    if (colorMap)
+        GifFreeMapObject(colorMap);
 
     progress.setValue(100);
 
@@ -677,50 +1157,74 @@ bool MainWindow::exportGif(const QString &fileName, QProgressDialog &progress)
 
 void MainWindow::onExportClicked()
 {
+    QString selectedFilter;
     QString fileName = QFileDialog::getSaveFileName(this,
                                                     "Export Animation", "spinner_animation.gif",
-                                                    "GIF Files (*.gif);;PNG Sequence (*.png)");
+                                                    "GIF Files (*.gif);;Animated PNG (*.apng);;PNG Sequence (*.png)",
+                                                    &selectedFilter);
 
     if (!fileName.isEmpty())
     {
-        if (fileName.endsWith(".gif", Qt::CaseInsensitive))
+        // Not every file dialog appends the suffix of the chosen filter
+        QString suffix = QFileInfo(fileName).suffix().toLower();
+        if (suffix != "gif" && suffix != "apng" && suffix != "png")
         {
-            // Show progress dialog
-            QProgressDialog progress("Exporting animation...", "Cancel", 0, 100, this);
-            progress.setWindowModality(Qt::WindowModal);
-            progress.setMinimumDuration(0);
-            progress.setValue(0);
-            progress.show();
-
-            // Export GIF
-            if (exportGif(fileName, progress))
-            {
-                progress.setValue(100);
-                QMessageBox::information(this, "Export", "Animation exported successfully!");
-            }
-            else
-            {
-                QMessageBox::critical(this, "Export Error", "Failed to export animation.");
-            }
+            suffix = selectedFilter.contains("*.apng") ? "apng" : selectedFilter.contains("*.png") ? "png" : "gif";
+            fileName += "." + suffix;
+        }
+
+        // Show progress dialog
+        QProgressDialog progress("Exporting animation...", "Cancel", 0, 100, this);
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(0);
+        progress.setValue(0);
+        progress.show();
+
+        bool exported;
+        if (suffix == "apng")
+            exported = exportApng(fileName, progress);
+        else if (suffix == "png")
+            exported = exportPngSequence(fileName, progress);
+        else
+            exported = exportGif(fileName, progress);
+        if (exported)
+        {
+            progress.setValue(100);
+            QMessageBox::information(this, "Export", "Animation exported successfully!");
+        }
+        else if (!progress.wasCanceled())
+        {
+            QMessageBox::critical(this, "Export Error", "Failed to export animation.");
         }
     }
 }
 
+void MainWindow::onExportSettingsClicked()
+{
+    const Scene &scene = m_canvas->scene();
+    ExportSettingsDialog dialog(m_exportSettings, QSize(scene.width(), scene.height()), this);
+    if (dialog.exec() == QDialog::Accepted)
+        m_exportSettings = dialog.settings();
+}
+
 void MainWindow::updateFrameRate()
 {
-    statusBar()->showMessage(QString("FPS: %1 - %2 spinners active")
+    statusBar()->showMessage(QString("FPS: %1 - %2 spinners active - Render: %3")
                                  .arg(m_frameCount)
-                                 .arg(m_canvas->getItems().size()));
+                                 .arg(m_canvas->getItems().size())
+                                 .arg(m_canvas->renderer().threadingDescription(m_canvas->width(), m_canvas->height())));
+
+    // A whole second without frames: the scheduler is idle, so is the counter
+    if (m_frameCount == 0)
+        m_fpsTimer->stop();
     m_frameCount = 0;
 }
 
-void MainWindow::updateAnimation()
+void MainWindow::onCanvasFrameAdvanced()
 {
-    if (m_isAnimating)
-    {
-        m_canvas->updateAnimation();
-        m_frameCount++;
-    }
+    m_frameCount++;
+    if (!m_fpsTimer->isActive())
+        m_fpsTimer->start();
 }
 
 void MainWindow::onCanvasItemSelected(int id)
@@ -767,7 +1271,7 @@ void MainWindow::updateItemList()
     for (const auto &item : items)
     {
         QString typeStr;
-        switch (item->type)
+        switch (item.type)
         {
         case SpinnerType::Circle:
             typeStr = "Circle";
@@ -788,12 +1292,12 @@ void MainWindow::updateItemList()
             break;
         }
 
-        QString itemText = QString("%1 (%2)").arg(item->name, typeStr);
+        QString itemText = QString("%1 (%2)").arg(item.name, typeStr);
         QListWidgetItem *listItem = new QListWidgetItem(itemText, m_itemList);
-        listItem->setData(Qt::UserRole, item->id);
+        listItem->setData(Qt::UserRole, item.id);
 
         QPixmap colorPixmap(16, 16);
-        colorPixmap.fill(QColor::fromString(item->color));
+        colorPixmap.fill(QColor::fromString(item.color));
         listItem->setIcon(QIcon(colorPixmap));
     }
 }
@@ -913,6 +1417,7 @@ void MainWindow::applyTemplate(int templateIndex)
 
         m_canvas->clearAll();
 
+        int number = 1;
         for (const auto &item : template_.items)
         {
             int id = m_canvas->addSpinner(
@@ -925,7 +1430,7 @@ void MainWindow::applyTemplate(int templateIndex)
                 item.duration,
                 item.preDelay,
                 item.postDelay);
-            m_canvas->setItemProperty(id, "name", QString("%1 %2").arg(template_.name).arg(id));
+            m_canvas->setItemProperty(id, "name", QString("%1 %2").arg(template_.name).arg(number++));
         }
 
         // Ensure animation is running
@@ -32,6 +32,8 @@
 #include <QScrollArea>
 #include <gif_lib.h>
 #include "CanvasWidget.h"
+#include "ExportSettings.h"
+#include "SceneRenderer.h"
 #include "SpinnerTemplates.h"
 #include "TemplateExplorerDialog.h"
 
@@ -64,9 +66,11 @@ private slots:
 
     // Animation
     void onStartStopClicked();
+    void onRenderThreadsClicked();
     void onExportClicked();
+    void onExportSettingsClicked();
     void updateFrameRate();
-    void updateAnimation();
+    void onCanvasFrameAdvanced();
 
     // Canvas events
     void onCanvasItemSelected(int id);
@@ -88,13 +92,17 @@ private:
     void updateItemProperties();
     void enableItemControls(bool enabled);
     void applyTemplate(int templateIndex);
-    QImage captureFrame();
+    static void captureFrame(const Scene &scene, double time, const QSize &size, SceneRenderer &renderer, QImage &target);
+    int exportWorkerCount(int frameCount) const;
     bool exportGif(const QString &fileName, QProgressDialog &progress);
+    bool exportPngSequence(const QString &fileName, QProgressDialog &progress);
+    bool exportApng(const QString &fileName, QProgressDialog &progress);
 
     // UI Components
     QSplitter *m_mainSplitter;
     QWidget *m_controlPanel;
     CanvasWidget *m_canvas;
+    SceneRenderer m_renderer;
 
     // Item List
     QGroupBox *m_itemListGroup;
@@ -127,12 +135,12 @@ private:
 
     // Timing
     QTimer *m_fpsTimer;
-    QTimer *m_animationTimer;
     int m_frameCount;
 
     // Settings
     QColor m_currentColor;
     bool m_isAnimating;
+    ExportSettings m_exportSettings;
     int m_selectedItemId;
     bool m_updatingControls;
 
@@ -0,0 +1,104 @@
+// Written by malekpour-dev.ir
+// PreviewCache keeps the pre-rendered loop of every template on disk, keyed by a hash of the
+// template content. Missing or outdated strips are rendered on a background thread.
+
+#include "PreviewCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QImage>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// Bump when the renderer output changes, old strips then simply stop matching
+static const int kCacheFormatVersion = 1;
+
+// Longer loops are cut, a preview does not need more than this
+static const int kMaxLoopSeconds = 4;
+
+PreviewCache::PreviewCache(int frameSize, int fps, QObject *parent)
+    : QObject(parent), m_frameSize(frameSize), m_fps(fps)
+{
+    QDir().mkpath(cacheDirectory());
+}
+
+PreviewCache::~PreviewCache()
+{
+    // Results queued to this object after it is gone are dropped by Qt
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QString PreviewCache::cacheDirectory()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("previews");
+}
+
+QByteArray PreviewCache::templateKey(const SpinnerTemplate &template_, int frameSize, int fps, int frameCount)
+{
+    QByteArray content;
+    QDataStream stream(&content, QIODevice::WriteOnly);
+    stream << kCacheFormatVersion << frameSize << fps << frameCount << static_cast<int>(template_.items.size());
+
+    // Names and descriptions are not part of the picture
+    for (const auto &item : template_.items)
+    {
+        stream << static_cast<int>(item.type) << static_cast<int>(item.anim) << item.position << item.size
+               << item.color << item.speed << item.duration << item.preDelay << item.postDelay;
+    }
+
+    return QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex();
+}
+
+void PreviewCache::request(int preview, const SpinnerTemplate &template_)
+{
+    if (m_strips.contains(preview))
+    {
+        emit stripReady(preview);
+        return;
+    }
+
+    ++m_pendingRequests;
+    Scene scene = SpinnerTemplates::buildScene(template_, m_frameSize, m_frameSize);
+    int frameSize = m_frameSize;
+    int fps = m_fps;
+
+    // The loop search scans the scene's items, it runs with the rendering off the GUI thread
+    m_pool.start([this, preview, template_, scene, frameSize, fps]()
+                 {
+        int frameCount = PreviewStrip::loopFrameCount(scene, fps, fps * kMaxLoopSeconds);
+        QString fileName = QString::fromLatin1(templateKey(template_, frameSize, fps, frameCount)) + ".png";
+        QString path = QDir(cacheDirectory()).filePath(fileName);
+
+        PreviewStrip strip = PreviewStrip::fromImage(QImage(path), frameSize, fps);
+        if (strip.isNull())
+        {
+            strip = PreviewStrip::render(scene, frameSize, fps, frameCount);
+
+            // Written aside and renamed, a dialog opened meanwhile never reads half a file
+            QSaveFile file(path);
+            if (file.open(QIODevice::WriteOnly) && strip.image().save(&file, "PNG"))
+                file.commit();
+        }
+
+        QMetaObject::invokeMethod(this, [this, preview, strip, fileName]()
+                                  {
+            m_strips.insert(preview, strip);
+            m_usedFiles.insert(fileName);
+            if (--m_pendingRequests == 0)
+                removeStaleStrips();
+            emit stripReady(preview); }, Qt::QueuedConnection); });
+}
+
+void PreviewCache::removeStaleStrips()
+{
+    // Strips of edited or removed templates, and of older renderers or preview sizes, would
+    // otherwise pile up: their keys never come back
+    QDir dir(cacheDirectory());
+    const QStringList files = dir.entryList({"*.png"}, QDir::Files);
+    for (const QString &file : files)
+    {
+        if (!m_usedFiles.contains(file))
+            dir.remove(file);
+    }
+}
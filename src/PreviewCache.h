@@ -0,0 +1,47 @@
+// Written by malekpour-dev.ir
+// PreviewCache keeps the pre-rendered loop of every template on disk, keyed by a hash of the
+// template content. Missing or outdated strips are rendered on a background thread.
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include "PreviewStrip.h"
+#include "SpinnerTemplates.h"
+
+class PreviewCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    PreviewCache(int frameSize, int fps, QObject *parent = nullptr);
+    ~PreviewCache();
+
+    // Loads the strip from disk, or renders and stores it, off the GUI thread. stripReady
+    // follows either way. Once every requested strip is in, files no request used are deleted.
+    void request(int preview, const SpinnerTemplate &template_);
+
+    // Null until stripReady was emitted for the preview
+    PreviewStrip strip(int preview) const { return m_strips.value(preview); }
+
+    // Changes whenever anything that affects the rendered frames changes, the loop length
+    // included so a change in how loops are found does not reuse strips of the old length
+    static QByteArray templateKey(const SpinnerTemplate &template_, int frameSize, int fps, int frameCount);
+    static QString cacheDirectory();
+
+signals:
+    void stripReady(int preview);
+
+private:
+    void removeStaleStrips();
+
+    int m_frameSize;
+    int m_fps;
+    QHash<int, PreviewStrip> m_strips;
+    QSet<QString> m_usedFiles;
+    int m_pendingRequests = 0;
+    QThreadPool m_pool;
+};
@@ -3,7 +3,8 @@
 
 #pragma once
 
-#include "CanvasWidget.h"
+#include "Scene.h"
+#include <QPointF>
 #include <QString>
 #include <vector>
 
@@ -27,6 +28,19 @@ struct SpinnerTemplate {
 
 class SpinnerTemplates {
 public:
+    // Template laid out on a scene of the given size, the same way CanvasWidget::addSpinner
+    // turns percent positions and sizes into pixels
+    static Scene buildScene(const SpinnerTemplate &template_, int width, int height) {
+        Scene scene(width, height);
+        for (const auto &item : template_.items) {
+            QPointF pixelPosition(width * item.position.x() / 100.0, height * item.position.y() / 100.0);
+            int pixelSize = width * item.size / 100.0;
+            scene.addItem(item.type, item.anim, pixelPosition, pixelSize, item.color, item.speed, item.duration,
+                          item.preDelay, item.postDelay);
+        }
+        return scene;
+    }
+
     static const std::vector<SpinnerTemplate>& getTemplates() {
         static const std::vector<SpinnerTemplate> templates = {
            
@@ -3,49 +3,118 @@
 // It displays a grid of templates with previews and allows the user to select one.
 
 #include "TemplateExplorerDialog.h"
+#include <QScrollBar>
+#include <QWindow>
 
-TemplateExplorerDialog::TemplateExplorerDialog(QWidget *parent) : QDialog(parent)
+// Previews are thumbnails, they do not need the editor canvas frame rate
+static const int kPreviewSize = 100;
+static const int kPreviewFps = 30;
+
+// Scheduler ticks come a little early or late, a tick this close to the next preview
+// frame still draws it instead of leaving the previews a whole tick behind
+static const double kPreviewSlack = 0.004;
+
+TemplateExplorerDialog::TemplateExplorerDialog(QWidget *parent)
+    : QDialog(parent), m_atlas(kPreviewSize), m_cache(kPreviewSize, kPreviewFps)
 {
     setWindowTitle("Template Explorer");
     setFixedSize(600, 600);
+
+    connect(&m_cache, &PreviewCache::stripReady, this, [this](int preview)
+            {
+        m_previews[preview]->setStrip(m_cache.strip(preview));
+        if (isVisible())
+            renderPreviews(); });
+
     setupUI();
-    QTimer::singleShot(0, this, &TemplateExplorerDialog::setupAnimationTimer);
+    FrameScheduler::instance().registerClient(this);
 }
 
 TemplateExplorerDialog::~TemplateExplorerDialog()
 {
-    if (m_animationTimer)
-    {
-        m_animationTimer->stop();
-        delete m_animationTimer;
-    }
+    FrameScheduler::instance().unregisterClient(this);
+}
 
-    
-    for (auto *canvas : m_previewCanvases)
-    {
-        delete canvas;
-    }
-    m_previewCanvases.clear();
+void TemplateExplorerDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    if (!m_previewClock.isValid())
+        m_previewClock.start();
+
+    renderPreviews();
 }
 
-void TemplateExplorerDialog::onTemplateSelected(int templateIndex)
+void TemplateExplorerDialog::hideEvent(QHideEvent *event)
 {
-    m_selectedTemplateIndex = templateIndex;
-    accept();
+    QDialog::hideEvent(event);
+    m_previewsAnimating = false;
+}
+
+bool TemplateExplorerDialog::wantsFrames() const
+{
+    if (!m_previewsAnimating || !isVisible())
+        return false;
+
+    const QWindow *handle = windowHandle();
+    return handle && handle->isExposed();
 }
 
-void TemplateExplorerDialog::updatePreviews()
+void TemplateExplorerDialog::advanceFrame()
 {
-    if (!isVisible())
+    double time = m_previewClock.nsecsElapsed() / 1e9;
+    if (time + kPreviewSlack < m_nextPreviewTime)
         return;
 
-    for (auto *canvas : m_previewCanvases)
+    // Frame times stay on a fixed grid so the rate holds on screens it does not divide,
+    // after a stall the grid restarts from now instead of catching up
+    m_nextPreviewTime += 1.0 / kPreviewFps;
+    if (m_nextPreviewTime < time)
+        m_nextPreviewTime = time + 1.0 / kPreviewFps;
+
+    renderPreviews();
+}
+
+void TemplateExplorerDialog::renderPreviews()
+{
+    double time = m_previewClock.nsecsElapsed() / 1e9;
+
+    // Only previews inside the scroll viewport are advanced. Cached ones just pick their
+    // next strip frame, the others are rendered live until their strip arrives.
+    m_visiblePreviews.clear();
+    bool animating = false;
+    for (auto *preview : m_previews)
     {
-        if (canvas && canvas->isVisible())
+        if (preview->visibleRegion().isEmpty())
+            continue;
+
+        if (preview->hasStrip())
         {
-            canvas->updateAnimation();
+            preview->setTime(time);
+            preview->update();
+            animating = animating || preview->strip().frameCount() > 1;
+            continue;
         }
+
+        m_visiblePreviews.push_back(preview->preview());
+        animating = animating || m_atlas.scene(preview->preview()).hasAnimatedItems();
+    }
+
+    m_atlas.render(m_visiblePreviews, time);
+
+    for (int preview : m_visiblePreviews)
+    {
+        m_previews[preview]->update();
     }
+
+    m_previewsAnimating = animating;
+    if (animating && isVisible())
+        FrameScheduler::instance().wake();
+}
+
+void TemplateExplorerDialog::onTemplateSelected(int templateIndex)
+{
+    m_selectedTemplateIndex = templateIndex;
+    accept();
 }
 
 void TemplateExplorerDialog::setupUI()
@@ -98,30 +167,13 @@ void TemplateExplorerDialog::setupUI()
         descLabel->setStyleSheet("color: #666; font-size: 10px;");
         previewLayout->addWidget(descLabel);
         
-        CanvasWidget *previewCanvas = new CanvasWidget(previewContainer);
-        previewCanvas->setFixedSize(100, 100);
-        previewCanvas->setStyleSheet("border: 1px solid #ddd; border-radius: 4px; background: #f8f8f8;");
-        previewCanvas->setEnabled(false);
-        m_previewCanvases.push_back(previewCanvas);
-
-        
-        for (const auto &item : template_.items)
-        {
-            previewCanvas->addSpinner(
-                item.type,
-                item.anim,
-                item.position,
-                item.size,
-                item.color,
-                item.speed,
-                item.duration,
-                item.preDelay,
-                item.postDelay);
-        }
-
-        
-        previewCanvas->setAnimating(true);
-        previewLayout->addWidget(previewCanvas, 0, Qt::AlignCenter);
+        int preview = m_atlas.addScene(SpinnerTemplates::buildScene(template_, kPreviewSize, kPreviewSize));
+        TemplatePreviewWidget *previewWidget = new TemplatePreviewWidget(m_atlas, preview, previewContainer);
+        previewWidget->setStyleSheet("border: 1px solid #ddd; border-radius: 4px; background: #f8f8f8;");
+        previewWidget->setEnabled(false);
+        m_previews.push_back(previewWidget);
+        m_cache.request(preview, template_);
+        previewLayout->addWidget(previewWidget, 0, Qt::AlignCenter);
 
         
         QPushButton *applyButton = new QPushButton("Apply Template");
@@ -161,17 +213,9 @@ void TemplateExplorerDialog::setupUI()
     
     scrollArea->setWidget(contentWidget);
     mainLayout->addWidget(scrollArea);
-}
-
-void TemplateExplorerDialog::setupAnimationTimer()
-{
-    if (m_animationTimer)
-    {
-        m_animationTimer->stop();
-        delete m_animationTimer;
-    }
 
-    m_animationTimer = new QTimer(this);
-    connect(m_animationTimer, &QTimer::timeout, this, &TemplateExplorerDialog::updatePreviews);
-    m_animationTimer->start(16); 
-}
\ No newline at end of file
+    // Previews scrolled into view are drawn right away instead of on the next tick
+    connect(scrollArea->verticalScrollBar(), &QScrollBar::valueChanged, this, &TemplateExplorerDialog::renderPreviews);
+    connect(scrollArea->horizontalScrollBar(), &QScrollBar::valueChanged, this,
+            &TemplateExplorerDialog::renderPreviews);
+}
@@ -9,11 +9,14 @@
 #include <QScrollArea>
 #include <QPushButton>
 #include <QLabel>
-#include <QTimer>
-#include "CanvasWidget.h"
+#include <QElapsedTimer>
+#include "FrameScheduler.h"
+#include "PreviewAtlas.h"
+#include "PreviewCache.h"
 #include "SpinnerTemplates.h"
+#include "TemplatePreviewWidget.h"
 
-class TemplateExplorerDialog : public QDialog {
+class TemplateExplorerDialog : public QDialog, public FrameClient {
     Q_OBJECT
 
 public:
@@ -21,17 +24,30 @@ public:
     ~TemplateExplorerDialog();
     int getSelectedTemplateIndex() const { return m_selectedTemplateIndex; }
 
+    // Ticked by the frame scheduler, previews take the ticks that reach their own frame rate
+    bool wantsFrames() const override;
+    void advanceFrame() override;
+    QScreen *frameScreen() const override { return screen(); }
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
 private slots:
     void onTemplateSelected(int templateIndex);
-    void updatePreviews();
+    void renderPreviews();
 
 private:
     void setupUI();
-    void setupAnimationTimer();
 
     int m_selectedTemplateIndex = -1;
-    QTimer *m_animationTimer = nullptr;
-    std::vector<CanvasWidget*> m_previewCanvases;
+    PreviewAtlas m_atlas;
+    PreviewCache m_cache;
+    std::vector<TemplatePreviewWidget*> m_previews;
+    std::vector<int> m_visiblePreviews;
+    QElapsedTimer m_previewClock;
+    double m_nextPreviewTime = 0.0;
+    bool m_previewsAnimating = false;
     QGridLayout *m_gridLayout = nullptr;
     std::vector<SpinnerTemplate> m_templates;
 }; 
\ No newline at end of file
@@ -0,0 +1,48 @@
+// Written by malekpour-dev.ir
+// TemplatePreviewWidget shows a template preview, a frame of its cached strip once loaded and
+// its tile of the shared PreviewAtlas until then. It renders nothing itself.
+
+#include "TemplatePreviewWidget.h"
+#include <QImage>
+#include <QPainter>
+
+TemplatePreviewWidget::TemplatePreviewWidget(const PreviewAtlas &atlas, int preview, QWidget *parent)
+    : QWidget(parent), m_atlas(atlas), m_preview(preview)
+{
+    setFixedSize(atlas.tileSize(), atlas.tileSize());
+    setAutoFillBackground(true);
+    QPalette pal = palette();
+    pal.setColor(QPalette::Window, Qt::white);
+    setPalette(pal);
+}
+
+void TemplatePreviewWidget::setStrip(const PreviewStrip &strip)
+{
+    m_strip = strip;
+    update();
+}
+
+void TemplatePreviewWidget::paintEvent(QPaintEvent *)
+{
+    if (hasStrip())
+    {
+        QPainter painter(this);
+        painter.drawImage(QPoint(0, 0), m_strip.image(), m_strip.frameRect(m_time));
+        return;
+    }
+
+    BLRectI tile;
+    if (!m_atlas.tileOf(m_preview, tile))
+        return;
+
+    BLImageData data;
+    if (m_atlas.image().getData(&data) != BL_SUCCESS)
+        return;
+
+    // Wraps the atlas pixels without copying, only the tile of this preview is drawn
+    QImage atlasImage(static_cast<const uchar *>(data.pixelData), data.size.w, data.size.h, data.stride,
+                      QImage::Format_ARGB32_Premultiplied);
+
+    QPainter painter(this);
+    painter.drawImage(QPoint(0, 0), atlasImage, QRect(tile.x, tile.y, tile.w, tile.h));
+}
@@ -0,0 +1,34 @@
+// Written by malekpour-dev.ir
+// TemplatePreviewWidget shows a template preview, a frame of its cached strip once loaded and
+// its tile of the shared PreviewAtlas until then. It renders nothing itself.
+
+#pragma once
+
+#include <QWidget>
+#include "PreviewAtlas.h"
+#include "PreviewStrip.h"
+
+class TemplatePreviewWidget : public QWidget
+{
+public:
+    TemplatePreviewWidget(const PreviewAtlas &atlas, int preview, QWidget *parent = nullptr);
+
+    int preview() const { return m_preview; }
+
+    // Once set, the preview is played from the strip and needs no atlas tile
+    void setStrip(const PreviewStrip &strip);
+    bool hasStrip() const { return !m_strip.isNull(); }
+    const PreviewStrip &strip() const { return m_strip; }
+
+    // Scene time of the strip frame to show
+    void setTime(double time) { m_time = time; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    const PreviewAtlas &m_atlas;
+    int m_preview;
+    PreviewStrip m_strip;
+    double m_time = 0.0;
+};
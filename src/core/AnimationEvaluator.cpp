@@ -0,0 +1,422 @@
+// Written by malekpour-dev.ir
+// AnimationEvaluator computes the pose of every item at a scene time in one batch:
+// a flat copy of the item parameters goes through a vectorized phase and sin/cos pass.
+
+#include "AnimationEvaluator.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TWIQ_EVALUATOR_X86 1
+#include <immintrin.h>
+#define TWIQ_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+using PhaseInput = AnimationEvaluator::PhaseInput;
+using PhaseOutput = AnimationEvaluator::PhaseOutput;
+
+static const double kTwoPi = 6.283185307179586;
+
+// Taylor terms of sin(y) up to y^13, under 1e-9 off on [-pi/2, pi/2]
+static const double kSin3 = -1.0 / 6.0;
+static const double kSin5 = 1.0 / 120.0;
+static const double kSin7 = -1.0 / 5040.0;
+static const double kSin9 = 1.0 / 362880.0;
+static const double kSin11 = -1.0 / 39916800.0;
+static const double kSin13 = 1.0 / 6227020800.0;
+
+// Bounce runs half a sine wave per cycle, every other animation a full one
+static double cycleFrequency(SpinnerAnimation anim)
+{
+    return anim == SpinnerAnimation::Bounce ? 0.5 : 1.0;
+}
+
+// sin(2 * pi * x). The SIMD kernels below repeat these exact steps lane by lane.
+static inline double sin2pi(double x)
+{
+    x -= std::floor(x + 0.5);
+    double a = std::abs(x);
+    double y = kTwoPi * std::min(a, 0.5 - a);
+    double y2 = y * y;
+
+    double p = kSin13;
+    p = p * y2 + kSin11;
+    p = p * y2 + kSin9;
+    p = p * y2 + kSin7;
+    p = p * y2 + kSin5;
+    p = p * y2 + kSin3;
+    p = p * y2 + 1.0;
+    return std::copysign(p * y, x);
+}
+
+// Where an item is in its cycle: u is the phase inside the animated window scaled by the
+// frequency, 0 outside of it. Returns whether the time falls inside the window.
+static inline bool cyclePhase(double time, double speed, double cycle, double start, double end, double duration,
+                              double frequency, double &u)
+{
+    double position = 0.0;
+    if (cycle > 0.0)
+    {
+        // Negative speeds play the cycle backwards instead of freezing it
+        double local = time * speed / 100.0 * kSpeedTimeScale;
+        position = local - std::floor(local / cycle) * cycle;
+        if (position < 0.0)
+            position += cycle;
+        if (position >= cycle)
+            position -= cycle;
+    }
+
+    bool window = position >= start && position < end;
+    u = window ? (position - start) / duration * frequency : 0.0;
+    return window;
+}
+
+static void phaseScalar(const PhaseInput &in, double time, size_t begin, size_t count, const PhaseOutput &out)
+{
+    for (size_t i = begin; i < count; ++i)
+    {
+        double u;
+        out.window[i] = cyclePhase(time, in.speed[i], in.cycle[i], in.start[i], in.end[i], in.duration[i],
+                                   in.frequency[i], u);
+        out.sin[i] = sin2pi(u);
+        out.cos[i] = sin2pi(u + 0.25);
+    }
+}
+
+#ifdef TWIQ_EVALUATOR_X86
+
+TWIQ_TARGET("avx2") static inline __m256d sin2piAvx2(__m256d x)
+{
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+
+    x = _mm256_sub_pd(x, _mm256_floor_pd(_mm256_add_pd(x, half)));
+    __m256d sign = _mm256_and_pd(x, signMask);
+    __m256d a = _mm256_andnot_pd(signMask, x);
+    __m256d y = _mm256_mul_pd(_mm256_set1_pd(kTwoPi), _mm256_min_pd(a, _mm256_sub_pd(half, a)));
+    __m256d y2 = _mm256_mul_pd(y, y);
+
+    __m256d p = _mm256_set1_pd(kSin13);
+    p = _mm256_add_pd(_mm256_mul_pd(p, y2), _mm256_set1_pd(kSin11));
+    p = _mm256_add_pd(_mm256_mul_pd(p, y2), _mm256_set1_pd(kSin9));
+    p = _mm256_add_pd(_mm256_mul_pd(p, y2), _mm256_set1_pd(kSin7));
+    p = _mm256_add_pd(_mm256_mul_pd(p, y2), _mm256_set1_pd(kSin5));
+    p = _mm256_add_pd(_mm256_mul_pd(p, y2), _mm256_set1_pd(kSin3));
+    p = _mm256_add_pd(_mm256_mul_pd(p, y2), _mm256_set1_pd(1.0));
+    return _mm256_or_pd(_mm256_mul_pd(p, y), sign);
+}
+
+TWIQ_TARGET("avx2") static void phaseAvx2(const PhaseInput &in, double time, size_t count, const PhaseOutput &out)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d t = _mm256_set1_pd(time);
+    const __m256d hundred = _mm256_set1_pd(100.0);
+    const __m256d timeScale = _mm256_set1_pd(kSpeedTimeScale);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d cycle = _mm256_loadu_pd(in.cycle + i);
+        __m256d hasCycle = _mm256_cmp_pd(cycle, zero, _CMP_GT_OQ);
+        cycle = _mm256_blendv_pd(one, cycle, hasCycle);
+
+        __m256d local = _mm256_mul_pd(_mm256_div_pd(_mm256_mul_pd(t, _mm256_loadu_pd(in.speed + i)), hundred),
+                                      timeScale);
+        __m256d position = _mm256_sub_pd(local, _mm256_mul_pd(_mm256_floor_pd(_mm256_div_pd(local, cycle)), cycle));
+        position = _mm256_add_pd(position, _mm256_and_pd(_mm256_cmp_pd(position, zero, _CMP_LT_OQ), cycle));
+        position = _mm256_sub_pd(position, _mm256_and_pd(_mm256_cmp_pd(position, cycle, _CMP_GE_OQ), cycle));
+        position = _mm256_and_pd(position, hasCycle);
+
+        __m256d start = _mm256_loadu_pd(in.start + i);
+        __m256d window = _mm256_and_pd(_mm256_cmp_pd(position, start, _CMP_GE_OQ),
+                                       _mm256_cmp_pd(position, _mm256_loadu_pd(in.end + i), _CMP_LT_OQ));
+
+        __m256d u = _mm256_div_pd(_mm256_sub_pd(position, start), _mm256_loadu_pd(in.duration + i));
+        u = _mm256_and_pd(_mm256_mul_pd(u, _mm256_loadu_pd(in.frequency + i)), window);
+
+        _mm256_storeu_pd(out.sin + i, sin2piAvx2(u));
+        _mm256_storeu_pd(out.cos + i, sin2piAvx2(_mm256_add_pd(u, quarter)));
+
+        int mask = _mm256_movemask_pd(window);
+        out.window[i] = mask & 1;
+        out.window[i + 1] = (mask >> 1) & 1;
+        out.window[i + 2] = (mask >> 2) & 1;
+        out.window[i + 3] = (mask >> 3) & 1;
+    }
+
+    phaseScalar(in, time, i, count, out);
+}
+
+TWIQ_TARGET("sse4.1") static inline __m128d sin2piSse41(__m128d x)
+{
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+
+    x = _mm_sub_pd(x, _mm_floor_pd(_mm_add_pd(x, half)));
+    __m128d sign = _mm_and_pd(x, signMask);
+    __m128d a = _mm_andnot_pd(signMask, x);
+    __m128d y = _mm_mul_pd(_mm_set1_pd(kTwoPi), _mm_min_pd(a, _mm_sub_pd(half, a)));
+    __m128d y2 = _mm_mul_pd(y, y);
+
+    __m128d p = _mm_set1_pd(kSin13);
+    p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(kSin11));
+    p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(kSin9));
+    p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(kSin7));
+    p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(kSin5));
+    p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(kSin3));
+    p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(1.0));
+    return _mm_or_pd(_mm_mul_pd(p, y), sign);
+}
+
+TWIQ_TARGET("sse4.1") static void phaseSse41(const PhaseInput &in, double time, size_t count, const PhaseOutput &out)
+{
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d quarter = _mm_set1_pd(0.25);
+    const __m128d t = _mm_set1_pd(time);
+    const __m128d hundred = _mm_set1_pd(100.0);
+    const __m128d timeScale = _mm_set1_pd(kSpeedTimeScale);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d cycle = _mm_loadu_pd(in.cycle + i);
+        __m128d hasCycle = _mm_cmpgt_pd(cycle, zero);
+        cycle = _mm_blendv_pd(one, cycle, hasCycle);
+
+        __m128d local = _mm_mul_pd(_mm_div_pd(_mm_mul_pd(t, _mm_loadu_pd(in.speed + i)), hundred), timeScale);
+        __m128d position = _mm_sub_pd(local, _mm_mul_pd(_mm_floor_pd(_mm_div_pd(local, cycle)), cycle));
+        position = _mm_add_pd(position, _mm_and_pd(_mm_cmplt_pd(position, zero), cycle));
+        position = _mm_sub_pd(position, _mm_and_pd(_mm_cmpge_pd(position, cycle), cycle));
+        position = _mm_and_pd(position, hasCycle);
+
+        __m128d start = _mm_loadu_pd(in.start + i);
+        __m128d window = _mm_and_pd(_mm_cmpge_pd(position, start), _mm_cmplt_pd(position, _mm_loadu_pd(in.end + i)));
+
+        __m128d u = _mm_div_pd(_mm_sub_pd(position, start), _mm_loadu_pd(in.duration + i));
+        u = _mm_and_pd(_mm_mul_pd(u, _mm_loadu_pd(in.frequency + i)), window);
+
+        _mm_storeu_pd(out.sin + i, sin2piSse41(u));
+        _mm_storeu_pd(out.cos + i, sin2piSse41(_mm_add_pd(u, quarter)));
+
+        int mask = _mm_movemask_pd(window);
+        out.window[i] = mask & 1;
+        out.window[i + 1] = (mask >> 1) & 1;
+    }
+
+    phaseScalar(in, time, i, count, out);
+}
+
+#endif
+
+// Turns the phase results of one item into its transform and alpha.
+// s and c are sin and cos of 2 * pi * u, see cyclePhase().
+static inline void assemblePose(SpinnerAnimation anim, double x, double y, bool window, double s, double c,
+                                uint8_t baseAlpha, BLMatrix2D &transform, uint8_t &alpha)
+{
+    transform.reset(1.0, 0.0, 0.0, 1.0, x, y);
+    alpha = baseAlpha;
+
+    if (!window)
+        return;
+
+    switch (anim)
+    {
+    case SpinnerAnimation::None:
+        break;
+    case SpinnerAnimation::Rotate:
+        transform.reset(c, s, -s, c, x, y);
+        break;
+    case SpinnerAnimation::Scale:
+    {
+        double scale = 0.5 + 0.5 * (1.0 + s);
+        transform.reset(scale, 0.0, 0.0, scale, x, y);
+        break;
+    }
+    case SpinnerAnimation::Fade:
+    {
+        double fade = 0.1 + 0.9 * (0.5 * (1.0 + s));
+        alpha = static_cast<uint8_t>(fade * 255.0);
+        break;
+    }
+    case SpinnerAnimation::Bounce:
+    {
+        // Half a sine per cycle: up and back down, squashed while moving fast
+        double bounceHeight = 20.0;
+        double verticalPos = std::abs(s) * bounceHeight;
+        double scaleX = 1.0 + 0.2 * std::abs(c);
+        double scaleY = 1.0 - 0.2 * std::abs(c);
+        transform.reset(scaleX, 0.0, 0.0, scaleY, x, y - verticalPos);
+        break;
+    }
+    case SpinnerAnimation::Slide:
+        transform.reset(1.0, 0.0, 0.0, 1.0, x + 20.0 * s, y);
+        break;
+    }
+}
+
+// Stars reach out to item.size from the center, every other shape to half of it
+static double shapeExtent(const SpinnerItem &item)
+{
+    return item.type == SpinnerType::Star ? item.size : item.size / 2.0;
+}
+
+static bool isRunning(SpinnerAnimation anim, double speed)
+{
+    return anim != SpinnerAnimation::None && speed != 0.0;
+}
+
+static AnimationEvaluator::Path detectPath()
+{
+#ifdef TWIQ_EVALUATOR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return AnimationEvaluator::Path::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return AnimationEvaluator::Path::SSE41;
+#endif
+    return AnimationEvaluator::Path::Scalar;
+}
+
+AnimationEvaluator::AnimationEvaluator()
+    : m_path(bestPath())
+{
+}
+
+AnimationEvaluator::Path AnimationEvaluator::bestPath()
+{
+    static const Path best = detectPath();
+    return best;
+}
+
+void AnimationEvaluator::setPath(Path path)
+{
+    m_path = std::min(path, bestPath());
+}
+
+const char *AnimationEvaluator::pathName(Path path)
+{
+    switch (path)
+    {
+    case Path::Scalar:
+        return "scalar";
+    case Path::SSE41:
+        return "SSE4.1";
+    case Path::AVX2:
+        return "AVX2";
+    }
+    return "scalar";
+}
+
+void AnimationEvaluator::snapshot(const Scene &scene)
+{
+    const auto &items = scene.items();
+    size_t count = items.size();
+
+    m_sceneWidth = scene.width();
+    m_sceneHeight = scene.height();
+
+    m_speed.resize(count);
+    m_cycle.resize(count);
+    m_start.resize(count);
+    m_end.resize(count);
+    m_duration.resize(count);
+    m_frequency.resize(count);
+    m_x.resize(count);
+    m_y.resize(count);
+    m_extent.resize(count);
+    m_anim.resize(count);
+    m_baseAlpha.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const SpinnerItem &item = items[i];
+        m_speed[i] = item.speed;
+        m_cycle[i] = item.cycleTime();
+        m_start[i] = item.preDelay;
+        m_end[i] = static_cast<double>(item.preDelay) + item.duration;
+        m_duration[i] = item.duration;
+        m_frequency[i] = cycleFrequency(item.anim);
+        m_x[i] = item.position.x();
+        m_y[i] = item.position.y();
+        m_extent[i] = shapeExtent(item);
+        m_anim[i] = item.anim;
+        m_baseAlpha[i] = static_cast<uint8_t>(item.rgba.a());
+    }
+}
+
+void AnimationEvaluator::evaluate(const Scene &scene, double time)
+{
+    snapshot(scene);
+    evaluate(time);
+}
+
+void AnimationEvaluator::evaluate(double time)
+{
+    size_t count = m_speed.size();
+
+    m_sin.resize(count);
+    m_cos.resize(count);
+    m_window.resize(count);
+    m_transforms.resize(count);
+    m_alpha.resize(count);
+    m_bounds.resize(count);
+    m_flags.resize(count);
+
+    const PhaseInput in{m_speed.data(), m_cycle.data(), m_start.data(), m_end.data(), m_duration.data(),
+                        m_frequency.data()};
+    const PhaseOutput out{m_sin.data(), m_cos.data(), m_window.data()};
+
+    switch (m_path)
+    {
+#ifdef TWIQ_EVALUATOR_X86
+    case Path::AVX2:
+        phaseAvx2(in, time, count, out);
+        break;
+    case Path::SSE41:
+        phaseSse41(in, time, count, out);
+        break;
+#endif
+    default:
+        phaseScalar(in, time, 0, count, out);
+        break;
+    }
+
+    bool clipToScene = m_sceneWidth > 0 && m_sceneHeight > 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        BLMatrix2D &transform = m_transforms[i];
+        assemblePose(m_anim[i], m_x[i], m_y[i], m_window[i], m_sin[i], m_cos[i], m_baseAlpha[i], transform,
+                     m_alpha[i]);
+
+        // Half extents of the shape square mapped through the transform, plus one pixel for anti-aliasing
+        double halfWidth = m_extent[i] * (std::abs(transform.m00) + std::abs(transform.m10)) + 1.0;
+        double halfHeight = m_extent[i] * (std::abs(transform.m01) + std::abs(transform.m11)) + 1.0;
+        BLBox &box = m_bounds[i];
+        box.reset(transform.m20 - halfWidth, transform.m21 - halfHeight,
+                  transform.m20 + halfWidth, transform.m21 + halfHeight);
+
+        bool visible = !clipToScene ||
+                       (box.x1 > 0.0 && box.y1 > 0.0 && box.x0 < m_sceneWidth && box.y0 < m_sceneHeight);
+
+        m_flags[i] = (m_window[i] && isRunning(m_anim[i], m_speed[i]) ? kAnimating : 0) |
+                     (visible ? kVisible : 0);
+    }
+}
+
+AnimationEvaluator::Pose AnimationEvaluator::evaluateItem(const SpinnerItem &item, double time)
+{
+    double end = static_cast<double>(item.preDelay) + item.duration;
+    double u;
+    bool window = cyclePhase(time, item.speed, item.cycleTime(), item.preDelay, end, item.duration,
+                             cycleFrequency(item.anim), u);
+
+    Pose pose;
+    assemblePose(item.anim, item.position.x(), item.position.y(), window, sin2pi(u), sin2pi(u + 0.25),
+                 static_cast<uint8_t>(item.rgba.a()), pose.transform, pose.alpha);
+    pose.animating = window && isRunning(item.anim, item.speed);
+    return pose;
+}
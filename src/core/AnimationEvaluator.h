@@ -0,0 +1,115 @@
+// Written by malekpour-dev.ir
+// AnimationEvaluator computes the pose of every item at a scene time in one batch:
+// a flat copy of the item parameters goes through a vectorized phase and sin/cos pass.
+
+#pragma once
+
+#include <blend2d.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Scene.h"
+
+class AnimationEvaluator
+{
+public:
+    // Instruction sets of the batch pass, in increasing order of preference
+    enum class Path
+    {
+        Scalar,
+        SSE41,
+        AVX2
+    };
+
+    // Everything drawItem() needs to know about an item at one point in time
+    struct Pose
+    {
+        BLMatrix2D transform; // Position plus the animation offset
+        uint8_t alpha;        // Color alpha, the item's own or the faded one
+        bool animating;       // Inside the animated phase, false during delays or without animation
+    };
+
+    AnimationEvaluator();
+
+    // Best path this CPU supports; requesting a better one than that falls back to it
+    static Path bestPath();
+    void setPath(Path path);
+    Path path() const { return m_path; }
+    static const char *pathName(Path path);
+
+    // Copies the parameters of every item into flat arrays, in scene.items() order.
+    // Results refer to this snapshot until the next call.
+    void snapshot(const Scene &scene);
+
+    // Poses of all snapshot items at the given scene time
+    void evaluate(double time);
+
+    // snapshot() followed by evaluate()
+    void evaluate(const Scene &scene, double time);
+
+    // Scalar evaluation of a single item, same math as the batch pass
+    static Pose evaluateItem(const SpinnerItem &item, double time);
+
+    // Results of the last evaluate(), indexed like scene.items()
+    size_t size() const { return m_transforms.size(); }
+    const BLMatrix2D &transform(size_t index) const { return m_transforms[index]; }
+    uint8_t alpha(size_t index) const { return m_alpha[index]; }
+    float opacity(size_t index) const { return m_alpha[index] / 255.0f; }
+    bool isAnimating(size_t index) const { return m_flags[index] & kAnimating; }
+
+    // Box around everything drawItem() touches, anti-aliasing included
+    const BLBox &bounds(size_t index) const { return m_bounds[index]; }
+
+    // False when the item lies completely outside the scene rectangle
+    bool isVisible(size_t index) const { return m_flags[index] & kVisible; }
+
+    // Flat parameter arrays read by the batch pass, public for the SIMD kernels only
+    struct PhaseInput
+    {
+        const double *speed;
+        const double *cycle;
+        const double *start;
+        const double *end;
+        const double *duration;
+        const double *frequency;
+    };
+
+    struct PhaseOutput
+    {
+        double *sin;
+        double *cos;
+        uint8_t *window;
+    };
+
+private:
+    static constexpr uint8_t kAnimating = 1;
+    static constexpr uint8_t kVisible = 2;
+
+    Path m_path;
+    int m_sceneWidth = 0;
+    int m_sceneHeight = 0;
+
+    // Snapshot, one entry per item
+    std::vector<double> m_speed;
+    std::vector<double> m_cycle;
+    std::vector<double> m_start;
+    std::vector<double> m_end;
+    std::vector<double> m_duration;
+    std::vector<double> m_frequency;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<double> m_extent;
+    std::vector<SpinnerAnimation> m_anim;
+    std::vector<uint8_t> m_baseAlpha;
+
+    // Intermediate results of the phase pass
+    std::vector<double> m_sin;
+    std::vector<double> m_cos;
+    std::vector<uint8_t> m_window;
+
+    // Results
+    std::vector<BLMatrix2D> m_transforms;
+    std::vector<uint8_t> m_alpha;
+    std::vector<BLBox> m_bounds;
+    std::vector<uint8_t> m_flags;
+};
@@ -0,0 +1,125 @@
+// Written by malekpour-dev.ir
+// ApngDeltaEncoder turns full ARGB32 frames into what an APNG has to store: the rectangle
+// that changed, and whether it can be blended over the previous picture or must replace it.
+
+#include "ApngDeltaEncoder.h"
+#include <algorithm>
+
+ApngDeltaEncoder::ApngDeltaEncoder(int width, int height)
+    : m_width(width), m_height(height)
+{
+}
+
+QRect ApngDeltaEncoder::changedRect(const QImage &frame) const
+{
+    int x0 = m_width, y0 = m_height, x1 = -1, y1 = -1;
+    for (int y = 0; y < m_height; ++y)
+    {
+        const QRgb *before = reinterpret_cast<const QRgb *>(m_previous.constScanLine(y));
+        const QRgb *now = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+
+        int first = 0;
+        while (first < m_width && before[first] == now[first])
+        {
+            ++first;
+        }
+        if (first == m_width)
+            continue;
+
+        int last = m_width - 1;
+        while (before[last] == now[last])
+        {
+            --last;
+        }
+
+        x0 = std::min(x0, first);
+        x1 = std::max(x1, last);
+        y0 = std::min(y0, y);
+        y1 = y;
+    }
+
+    return x1 < 0 ? QRect() : QRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+bool ApngDeltaEncoder::addFrame(QImage &frame, int delay, ApngDeltaFrame &out)
+{
+    ApngDeltaFrame next;
+    next.delay = delay;
+
+    if (!m_hasPending)
+    {
+        // The first frame covers the whole canvas, over the transparent one players start from.
+        // Shared with the reference below, both only ever read it.
+        next.rect = QRect(0, 0, m_width, m_height);
+        next.pixels = frame;
+    }
+    else
+    {
+        QRect rect = changedRect(frame);
+
+        // Nothing moved, the pending frame just stays up longer
+        if (rect.isEmpty())
+        {
+            m_pending.delay += delay;
+            return false;
+        }
+
+        // Blending over only reproduces a pixel exactly when it is opaque or lands on a
+        // transparent one, otherwise the rectangle replaces what was there
+        next.rect = rect;
+        next.blendOver = true;
+        for (int y = rect.top(); y <= rect.bottom() && next.blendOver; ++y)
+        {
+            const QRgb *before = reinterpret_cast<const QRgb *>(m_previous.constScanLine(y));
+            const QRgb *now = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+            for (int x = rect.left(); x <= rect.right(); ++x)
+            {
+                if (before[x] != now[x] && qAlpha(now[x]) != 255 && qAlpha(before[x]) != 0)
+                {
+                    next.blendOver = false;
+                    break;
+                }
+            }
+        }
+
+        next.pixels = frame.copy(rect);
+        if (next.blendOver)
+        {
+            // Unchanged pixels left transparent, they compress far better
+            for (int y = 0; y < rect.height(); ++y)
+            {
+                const QRgb *before = reinterpret_cast<const QRgb *>(m_previous.constScanLine(rect.top() + y)) + rect.left();
+                QRgb *pixel = reinterpret_cast<QRgb *>(next.pixels.scanLine(y));
+                for (int x = 0; x < rect.width(); ++x)
+                {
+                    if (pixel[x] == before[x])
+                        pixel[x] = 0;
+                }
+            }
+        }
+    }
+
+    // The new frame is the reference from now on, the old reference buffer goes back. While
+    // the first frame's pixels still share it, rendering into it would copy it whole, so the
+    // caller gets a null image and allocates a fresh buffer instead.
+    std::swap(m_previous, frame);
+    if (!frame.isDetached())
+        frame = QImage();
+
+    bool emitted = m_hasPending;
+    if (emitted)
+        out = std::move(m_pending);
+    m_pending = std::move(next);
+    m_hasPending = true;
+    return emitted;
+}
+
+bool ApngDeltaEncoder::finish(ApngDeltaFrame &out)
+{
+    if (!m_hasPending)
+        return false;
+
+    out = std::move(m_pending);
+    m_hasPending = false;
+    return true;
+}
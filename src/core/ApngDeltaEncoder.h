@@ -0,0 +1,40 @@
+// Written by malekpour-dev.ir
+// ApngDeltaEncoder turns full ARGB32 frames into what an APNG has to store: the rectangle
+// that changed, and whether it can be blended over the previous picture or must replace it.
+
+#pragma once
+
+#include <QImage>
+#include <QRect>
+
+struct ApngDeltaFrame
+{
+    QRect rect;
+    bool blendOver = false; // APNG_BLEND_OP_OVER, unchanged pixels are transparent; otherwise SOURCE
+    int delay = 0;          // In frames of the caller, identical frames that followed are folded into it
+    QImage pixels;          // ARGB32 with straight alpha, rect sized
+};
+
+class ApngDeltaEncoder
+{
+public:
+    ApngDeltaEncoder(int width, int height);
+
+    // Takes the next ARGB32 frame. The frame becomes the reference for the next one and
+    // the buffer of the previous reference is handed back in its place, ready to be rendered
+    // into again, or a null image when that buffer is still in use. True when out holds the
+    // frame before it, whose delay is now known.
+    bool addFrame(QImage &frame, int delay, ApngDeltaFrame &out);
+
+    // The last frame. APNG players clear the canvas before every loop on their own.
+    bool finish(ApngDeltaFrame &out);
+
+private:
+    QRect changedRect(const QImage &frame) const;
+
+    int m_width;
+    int m_height;
+    QImage m_previous;
+    ApngDeltaFrame m_pending;
+    bool m_hasPending = false;
+};
@@ -0,0 +1,107 @@
+// Written by malekpour-dev.ir
+// DamageGrid collects the damaged rectangles of a frame on a coarse tile grid, so any number
+// of overlapping rectangles turns into a region in one pass instead of one union each.
+
+#include "DamageGrid.h"
+#include <algorithm>
+
+DamageGrid::DamageGrid(int tileSize)
+    : m_tileSize(std::max(1, tileSize))
+{
+}
+
+void DamageGrid::resize(int width, int height)
+{
+    m_width = std::max(0, width);
+    m_height = std::max(0, height);
+    m_columns = (m_width + m_tileSize - 1) / m_tileSize;
+    m_rows = (m_height + m_tileSize - 1) / m_tileSize;
+    m_tiles.assign(static_cast<size_t>(m_columns) * m_rows, 0);
+    m_empty = true;
+}
+
+void DamageGrid::add(const QRect &rect)
+{
+    QRect clipped = rect & QRect(0, 0, m_width, m_height);
+    if (clipped.isEmpty())
+        return;
+
+    int column0 = clipped.left() / m_tileSize;
+    int column1 = clipped.right() / m_tileSize;
+    int row1 = clipped.bottom() / m_tileSize;
+    for (int row = clipped.top() / m_tileSize; row <= row1; ++row)
+    {
+        uint8_t *tiles = m_tiles.data() + static_cast<size_t>(row) * m_columns;
+        std::fill(tiles + column0, tiles + column1 + 1, uint8_t(1));
+    }
+    m_empty = false;
+}
+
+QRegion DamageGrid::takeRegion()
+{
+    if (m_empty)
+        return QRegion();
+
+    // One band per tile row with a rectangle per run of marked tiles. A band with the same
+    // runs as the one above extends it instead, which is the banded form QRegion stores, so
+    // setRects() takes it as is.
+    m_rects.clear();
+    size_t bandStart = 0;
+    size_t bandSize = 0;
+    for (int row = 0; row < m_rows; ++row)
+    {
+        uint8_t *tiles = m_tiles.data() + static_cast<size_t>(row) * m_columns;
+        int top = row * m_tileSize;
+        int height = std::min(m_tileSize, m_height - top);
+
+        m_rowRuns.clear();
+        for (int column = 0; column < m_columns;)
+        {
+            if (!tiles[column])
+            {
+                ++column;
+                continue;
+            }
+
+            int first = column;
+            while (column < m_columns && tiles[column])
+            {
+                ++column;
+            }
+            int left = first * m_tileSize;
+            int right = std::min(column * m_tileSize, m_width);
+            m_rowRuns.push_back(QRect(left, top, right - left, height));
+        }
+        std::fill(tiles, tiles + m_columns, uint8_t(0));
+
+        if (m_rowRuns.empty())
+        {
+            bandSize = 0;
+            continue;
+        }
+
+        bool sameRuns = bandSize == m_rowRuns.size() &&
+                        std::equal(m_rowRuns.begin(), m_rowRuns.end(), m_rects.begin() + bandStart,
+                                   [](const QRect &a, const QRect &b)
+                                   {
+                                       return a.left() == b.left() && a.right() == b.right();
+                                   });
+        if (sameRuns)
+        {
+            for (size_t i = bandStart; i < m_rects.size(); ++i)
+            {
+                m_rects[i].setBottom(top + height - 1);
+            }
+            continue;
+        }
+
+        bandStart = m_rects.size();
+        bandSize = m_rowRuns.size();
+        m_rects.insert(m_rects.end(), m_rowRuns.begin(), m_rowRuns.end());
+    }
+    m_empty = true;
+
+    QRegion region;
+    region.setRects(m_rects.data(), static_cast<int>(m_rects.size()));
+    return region;
+}
@@ -0,0 +1,37 @@
+// Written by malekpour-dev.ir
+// DamageGrid collects the damaged rectangles of a frame on a coarse tile grid, so any number
+// of overlapping rectangles turns into a region in one pass instead of one union each.
+
+#pragma once
+
+#include <QRect>
+#include <QRegion>
+#include <cstdint>
+#include <vector>
+
+class DamageGrid
+{
+public:
+    explicit DamageGrid(int tileSize = 16);
+
+    // Matches the grid to the frame size and clears it
+    void resize(int width, int height);
+
+    // Marks every tile the rectangle touches, parts outside the frame are dropped
+    void add(const QRect &rect);
+    bool isEmpty() const { return m_empty; }
+
+    // The marked tiles clipped to the frame, then clears the grid for the next frame
+    QRegion takeRegion();
+
+private:
+    int m_tileSize;
+    int m_width = 0;
+    int m_height = 0;
+    int m_columns = 0;
+    int m_rows = 0;
+    bool m_empty = true;
+    std::vector<uint8_t> m_tiles;
+    std::vector<QRect> m_rects;
+    std::vector<QRect> m_rowRuns;
+};
@@ -0,0 +1,51 @@
+// Written by malekpour-dev.ir
+// ExportSettings holds everything an export depends on, so the same scene always exports to
+// the same file no matter how busy the editor was or how large its window is.
+
+#pragma once
+
+#include "Scene.h"
+#include <QSize>
+#include <algorithm>
+#include <cmath>
+
+struct ExportSettings
+{
+    int fps = 30;
+    int width = 0;  // Output pixels, 0 follows the scene
+    int height = 0; // Output pixels, 0 follows the scene
+
+    // Mixes delays that round up and down so the frame rate holds on average, instead of
+    // giving every frame the same whole centisecond delay
+    bool spreadDelays = true;
+
+    bool gifLocalPalettes = false; // One palette per GIF frame instead of a global one
+    bool gifBuiltinLzw = true;     // Built-in LZW encoder instead of giflib's
+
+    // Row filter of PNG frames. Adaptive lets the encoder pick per row, a fixed one is faster.
+    enum class PngFilter
+    {
+        Adaptive,
+        None,
+        Sub,
+        Up,
+        Average,
+        Paeth
+    };
+    int pngCompressionLevel = 6; // zlib level, 0 stores, 9 compresses hardest
+    PngFilter pngFilter = PngFilter::Adaptive;
+
+    // Size frames are rendered at. With one side left at 0 it keeps the scene's aspect.
+    QSize outputSize(const Scene &scene) const
+    {
+        if (width > 0 && height > 0)
+            return QSize(width, height);
+        if (scene.width() <= 0 || scene.height() <= 0)
+            return QSize(width, height);
+        if (width > 0)
+            return QSize(width, std::max(1, static_cast<int>(std::lround(static_cast<double>(width) * scene.height() / scene.width()))));
+        if (height > 0)
+            return QSize(std::max(1, static_cast<int>(std::lround(static_cast<double>(height) * scene.width() / scene.height()))), height);
+        return QSize(scene.width(), scene.height());
+    }
+};
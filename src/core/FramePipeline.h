@@ -0,0 +1,137 @@
+// Written by malekpour-dev.ir
+// FramePipeline produces numbered frames on worker threads and consumes them in order on the
+// calling thread, with at most a fixed window of frames in flight so memory stays flat.
+
+#pragma once
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+template <typename Result>
+class FramePipeline
+{
+public:
+    // Fills the result of a frame on a worker thread. The result object is a recycled slot,
+    // buffers it kept from an earlier frame can be reused.
+    using Produce = std::function<void(int frame, int worker, Result &result)>;
+
+    // Takes frames in order on the calling thread, false stops the pipeline
+    using Consume = std::function<bool(int frame, Result &result)>;
+
+    // Called on the calling thread while it waits, e.g. to process events. False cancels.
+    using Poll = std::function<bool()>;
+
+    FramePipeline(int frameCount, int workerCount, int window)
+        : m_frameCount(frameCount),
+          m_workerCount(std::max(1, workerCount)),
+          m_window(std::max(1, window)),
+          m_slots(m_window),
+          m_ready(m_window, 0)
+    {
+    }
+
+    // True when every frame was consumed
+    bool run(const Produce &produce, const Consume &consume, const Poll &poll)
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(m_workerCount);
+        for (int worker = 0; worker < m_workerCount; ++worker)
+        {
+            pool.start([this, &produce, worker]()
+                       { work(produce, worker); });
+        }
+
+        bool finished = consumeAll(consume, poll);
+
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stop = true;
+        }
+        m_slotFree.wakeAll();
+        pool.waitForDone();
+        return finished;
+    }
+
+private:
+    // Longest wait for the next frame before poll() runs again
+    static constexpr int kPollIntervalMs = 50;
+
+    void work(const Produce &produce, int worker)
+    {
+        for (;;)
+        {
+            int frame;
+            {
+                QMutexLocker locker(&m_mutex);
+
+                // A frame may only start once the frame window slots before it were consumed
+                while (!m_stop && m_nextFrame < m_frameCount && m_nextFrame >= m_nextConsumed + m_window)
+                {
+                    m_slotFree.wait(&m_mutex);
+                }
+                if (m_stop || m_nextFrame >= m_frameCount)
+                    return;
+
+                frame = m_nextFrame++;
+            }
+
+            produce(frame, worker, m_slots[frame % m_window]);
+
+            {
+                QMutexLocker locker(&m_mutex);
+                m_ready[frame % m_window] = 1;
+            }
+            m_frameReady.wakeAll();
+        }
+    }
+
+    bool consumeAll(const Consume &consume, const Poll &poll)
+    {
+        for (int frame = 0; frame < m_frameCount; ++frame)
+        {
+            int slot = frame % m_window;
+            {
+                QMutexLocker locker(&m_mutex);
+                while (!m_ready[slot])
+                {
+                    if (m_frameReady.wait(&m_mutex, kPollIntervalMs))
+                        continue;
+
+                    locker.unlock();
+                    if (!poll())
+                        return false;
+                    locker.relock();
+                }
+            }
+
+            if (!consume(frame, m_slots[slot]) || !poll())
+                return false;
+
+            {
+                QMutexLocker locker(&m_mutex);
+                m_ready[slot] = 0;
+                ++m_nextConsumed;
+            }
+            m_slotFree.wakeAll();
+        }
+        return true;
+    }
+
+    int m_frameCount;
+    int m_workerCount;
+    int m_window;
+    std::vector<Result> m_slots;
+    std::vector<char> m_ready;
+
+    QMutex m_mutex;
+    QWaitCondition m_frameReady;
+    QWaitCondition m_slotFree;
+    int m_nextFrame = 0;
+    int m_nextConsumed = 0;
+    bool m_stop = false;
+};
@@ -0,0 +1,174 @@
+// Written by malekpour-dev.ir
+// GifDeltaEncoder turns full indexed frames into what a GIF actually has to store: the
+// rectangle that changed, transparent where the previous picture shows through, and how
+// each frame is disposed of before the next one.
+
+#include "GifDeltaEncoder.h"
+#include <algorithm>
+
+// Disposal methods of the graphic control extension
+static const int kKeepFrame = 1;
+static const int kRestoreBackground = 2;
+
+GifDeltaEncoder::GifDeltaEncoder(int width, int height)
+    : m_width(width), m_height(height)
+{
+}
+
+void GifDeltaEncoder::takeColors(const QImage &indexed, std::vector<QRgb> &colors) const
+{
+    // Frames are compared by color, not index, so frames with local palettes diff correctly.
+    // Transparent pixels come out as 0, palette colors are opaque and never 0.
+    const QVector<QRgb> palette = indexed.colorTable();
+    colors.resize(static_cast<size_t>(m_width) * m_height);
+    for (int y = 0; y < m_height; ++y)
+    {
+        const uchar *line = indexed.constScanLine(y);
+        QRgb *out = colors.data() + static_cast<size_t>(y) * m_width;
+        for (int x = 0; x < m_width; ++x)
+        {
+            out[x] = line[x] ? palette[line[x]] : 0;
+        }
+    }
+}
+
+QRect GifDeltaEncoder::changedRect(const std::vector<QRgb> &a, const std::vector<QRgb> &b) const
+{
+    int x0 = m_width, y0 = m_height, x1 = -1, y1 = -1;
+    for (int y = 0; y < m_height; ++y)
+    {
+        const QRgb *rowA = a.data() + static_cast<size_t>(y) * m_width;
+        const QRgb *rowB = b.data() + static_cast<size_t>(y) * m_width;
+
+        int first = 0;
+        while (first < m_width && rowA[first] == rowB[first])
+        {
+            ++first;
+        }
+        if (first == m_width)
+            continue;
+
+        int last = m_width - 1;
+        while (rowA[last] == rowB[last])
+        {
+            --last;
+        }
+
+        x0 = std::min(x0, first);
+        x1 = std::max(x1, last);
+        y0 = std::min(y0, y);
+        y1 = y;
+    }
+
+    return x1 < 0 ? QRect() : QRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+bool GifDeltaEncoder::addFrame(const QImage &indexed, int delay, GifDeltaFrame &out)
+{
+    takeColors(indexed, m_next);
+
+    if (!m_hasPending)
+    {
+        // The screen starts out transparent
+        m_base.assign(m_next.size(), 0);
+        m_colors.swap(m_next);
+        m_indexed = indexed;
+        m_delay = delay;
+        m_rect = changedRect(m_base, m_colors);
+        m_hasPending = true;
+        return false;
+    }
+
+    // Nothing moved, the pending frame just stays up longer
+    if (m_next == m_colors)
+    {
+        m_delay += delay;
+        return false;
+    }
+
+    // Transparent pixels of a frame let the screen below show through, so pixels the next
+    // frame turns transparent can only be cleared by disposing of the pending frame
+    int x0 = m_width, y0 = m_height, x1 = -1, y1 = -1;
+    for (int y = 0; y < m_height; ++y)
+    {
+        const QRgb *now = m_colors.data() + static_cast<size_t>(y) * m_width;
+        const QRgb *next = m_next.data() + static_cast<size_t>(y) * m_width;
+        for (int x = 0; x < m_width; ++x)
+        {
+            if (now[x] && !next[x])
+            {
+                x0 = std::min(x0, x);
+                x1 = std::max(x1, x);
+                y0 = std::min(y0, y);
+                y1 = y;
+            }
+        }
+    }
+
+    if (x1 < 0)
+    {
+        m_disposal = kKeepFrame;
+    }
+    else
+    {
+        m_disposal = kRestoreBackground;
+        m_rect |= QRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+    }
+
+    emitPending(out);
+
+    // The next frame starts from what the screen shows once the pending one is disposed of
+    m_base.swap(m_colors);
+    if (m_disposal == kRestoreBackground)
+    {
+        for (int y = m_rect.top(); y <= m_rect.bottom(); ++y)
+        {
+            QRgb *row = m_base.data() + static_cast<size_t>(y) * m_width;
+            std::fill(row + m_rect.left(), row + m_rect.right() + 1, 0);
+        }
+    }
+
+    m_colors.swap(m_next);
+    m_indexed = indexed;
+    m_delay = delay;
+    m_rect = changedRect(m_base, m_colors);
+    return true;
+}
+
+bool GifDeltaEncoder::finish(GifDeltaFrame &out)
+{
+    if (!m_hasPending)
+        return false;
+
+    // Cleared down to an empty screen, which is what the first frame was encoded against
+    std::vector<QRgb> empty(m_colors.size(), 0);
+    m_disposal = kRestoreBackground;
+    m_rect |= changedRect(empty, m_colors);
+
+    emitPending(out);
+    m_hasPending = false;
+    return true;
+}
+
+void GifDeltaEncoder::emitPending(GifDeltaFrame &out) const
+{
+    // A frame must cover at least one pixel, one that keeps the screen as it is will do
+    out.rect = m_rect.isEmpty() ? QRect(0, 0, 1, 1) : m_rect;
+    out.disposal = m_disposal;
+    out.delay = m_delay;
+    out.palette = m_indexed.colorTable();
+    out.pixels.resize(static_cast<size_t>(out.rect.width()) * out.rect.height());
+
+    uint8_t *pixel = out.pixels.data();
+    for (int y = out.rect.top(); y <= out.rect.bottom(); ++y)
+    {
+        const uchar *line = m_indexed.constScanLine(y);
+        const QRgb *colors = m_colors.data() + static_cast<size_t>(y) * m_width;
+        const QRgb *base = m_base.data() + static_cast<size_t>(y) * m_width;
+        for (int x = out.rect.left(); x <= out.rect.right(); ++x)
+        {
+            // Unchanged pixels are left transparent, they compress far better
+            *pixel++ = colors[x] == base[x] ? 0 : line[x];
+        }
+    }
+}
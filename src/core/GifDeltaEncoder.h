@@ -0,0 +1,54 @@
+// Written by malekpour-dev.ir
+// GifDeltaEncoder turns full indexed frames into what a GIF actually has to store: the
+// rectangle that changed, transparent where the previous picture shows through, and how
+// each frame is disposed of before the next one.
+
+#pragma once
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+#include <cstdint>
+#include <vector>
+
+struct GifDeltaFrame
+{
+    QRect rect;
+    int disposal = 1;       // GIF disposal method, 1 leaves the frame in place, 2 clears its rectangle
+    int delay = 0;          // Centiseconds, identical frames that followed are folded into it
+    QVector<QRgb> palette;  // Color table the pixels index
+    std::vector<uint8_t> pixels; // rect.width() * rect.height() indices, row by row
+};
+
+class GifDeltaEncoder
+{
+public:
+    // Frames are indexed with transparent index 0, as PaletteMap produces them
+    GifDeltaEncoder(int width, int height);
+
+    // Takes the next frame. A frame is only final once the one after it shows how it must be
+    // disposed of, true when out holds such a frame.
+    bool addFrame(const QImage &indexed, int delay, GifDeltaFrame &out);
+
+    // The last frame, disposed of so that the loop starts over on an empty screen
+    bool finish(GifDeltaFrame &out);
+
+private:
+    void takeColors(const QImage &indexed, std::vector<QRgb> &colors) const;
+    QRect changedRect(const std::vector<QRgb> &a, const std::vector<QRgb> &b) const;
+    void emitPending(GifDeltaFrame &out) const;
+
+    int m_width;
+    int m_height;
+
+    // Frame waiting for its disposal method: its colors, what the screen showed before it and
+    // the area it changed
+    bool m_hasPending = false;
+    std::vector<QRgb> m_base;
+    std::vector<QRgb> m_colors;
+    std::vector<QRgb> m_next;
+    QImage m_indexed;
+    QRect m_rect;
+    int m_delay = 0;
+    int m_disposal = 1;
+};
@@ -0,0 +1,159 @@
+// Written by malekpour-dev.ir
+// GifLzwEncoder compresses a whole indexed frame into GIF image data in one pass, with a
+// directly indexed code table that is reset by bumping a generation instead of clearing it.
+
+#include "GifLzwEncoder.h"
+#include <algorithm>
+
+static const int kMaxCodeBits = 12;
+static const int kMaxCodes = 1 << kMaxCodeBits;
+static const int kCodeMask = kMaxCodes - 1;
+static const uint32_t kMaxGeneration = (1u << (32 - kMaxCodeBits)) - 1;
+static const int kMaxSubBlock = 255;
+
+namespace
+{
+// Packs codes LSB first into data sub-blocks of at most 255 bytes
+class CodeWriter
+{
+public:
+    explicit CodeWriter(uint8_t *out)
+        : m_start(out), m_blockLength(out), m_out(out + 1)
+    {
+    }
+
+    inline void put(uint32_t code, int bits)
+    {
+        m_bits |= static_cast<uint64_t>(code) << m_bitCount;
+        m_bitCount += bits;
+        while (m_bitCount >= 8)
+        {
+            putByte(static_cast<uint8_t>(m_bits));
+            m_bits >>= 8;
+            m_bitCount -= 8;
+        }
+    }
+
+    size_t finish()
+    {
+        if (m_bitCount > 0)
+            putByte(static_cast<uint8_t>(m_bits));
+
+        // A block without data would read as the terminator
+        if (m_length > 0)
+            *m_blockLength = static_cast<uint8_t>(m_length);
+        else
+            --m_out;
+        *m_out++ = 0;
+        return static_cast<size_t>(m_out - m_start);
+    }
+
+private:
+    inline void putByte(uint8_t byte)
+    {
+        if (m_length == kMaxSubBlock)
+        {
+            *m_blockLength = kMaxSubBlock;
+            m_blockLength = m_out++;
+            m_length = 0;
+        }
+        *m_out++ = byte;
+        ++m_length;
+    }
+
+    uint8_t *m_start;
+    uint8_t *m_blockLength;
+    uint8_t *m_out;
+    int m_length = 0;
+    uint64_t m_bits = 0;
+    int m_bitCount = 0;
+};
+} // namespace
+
+size_t GifLzwEncoder::maxEncodedSize(size_t pixelCount)
+{
+    // At worst one 12 bit code per pixel, a clear code every few thousand codes, the
+    // leading clear and the end code, and a length byte per 255 bytes of data
+    size_t codes = pixelCount + pixelCount / 1024 + 4;
+    size_t bytes = (codes * kMaxCodeBits + 7) / 8;
+    return bytes + bytes / kMaxSubBlock + 2;
+}
+
+size_t GifLzwEncoder::encode(const uint8_t *pixels, size_t count, int minCodeSize, uint8_t *out)
+{
+    const uint32_t clearCode = 1u << minCodeSize;
+    const uint32_t endCode = clearCode + 1;
+
+    size_t tableSize = static_cast<size_t>(kMaxCodes) << minCodeSize;
+    if (m_table.size() < tableSize)
+    {
+        m_table.assign(tableSize, 0);
+        m_generation = 0;
+    }
+
+    // Bumping the generation invalidates every entry at once, the table itself is only
+    // cleared when the generation runs out
+    auto reset = [this]()
+    {
+        if (++m_generation > kMaxGeneration)
+        {
+            std::fill(m_table.begin(), m_table.end(), 0);
+            m_generation = 1;
+        }
+    };
+
+    CodeWriter writer(out);
+    int codeSize = minCodeSize + 1;
+    uint32_t nextCode = endCode + 1;
+    reset();
+    writer.put(clearCode, codeSize);
+
+    if (count > 0)
+    {
+        uint32_t *table = m_table.data();
+        uint32_t stamp = m_generation << kMaxCodeBits;
+        uint32_t prefix = pixels[0];
+
+        for (size_t i = 1; i < count; ++i)
+        {
+            uint32_t pixel = pixels[i];
+            uint32_t &entry = table[(prefix << minCodeSize) | pixel];
+
+            // Flat runs stay in here, one lookup per pixel
+            if ((entry & ~static_cast<uint32_t>(kCodeMask)) == stamp)
+            {
+                prefix = entry & kCodeMask;
+                continue;
+            }
+
+            writer.put(prefix, codeSize);
+            if (nextCode < static_cast<uint32_t>(kMaxCodes))
+            {
+                entry = stamp | nextCode++;
+
+                // The decoder adds its entries one code later, so the width grows once the
+                // code just added no longer fits
+                if (nextCode > (1u << codeSize) && codeSize < kMaxCodeBits)
+                    ++codeSize;
+            }
+            else
+            {
+                writer.put(clearCode, codeSize);
+                reset();
+                stamp = m_generation << kMaxCodeBits;
+                codeSize = minCodeSize + 1;
+                nextCode = endCode + 1;
+            }
+            prefix = pixel;
+        }
+
+        writer.put(prefix, codeSize);
+
+        // The decoder still adds an entry for the last code before it reads the end code
+        if (nextCode < static_cast<uint32_t>(kMaxCodes) && ++nextCode > (1u << codeSize) && codeSize < kMaxCodeBits)
+            ++codeSize;
+    }
+
+    writer.put(endCode, codeSize);
+    return writer.finish();
+}
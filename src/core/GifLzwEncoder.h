@@ -0,0 +1,27 @@
+// Written by malekpour-dev.ir
+// GifLzwEncoder compresses a whole indexed frame into GIF image data in one pass, with a
+// directly indexed code table that is reset by bumping a generation instead of clearing it.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class GifLzwEncoder
+{
+public:
+    // Most bytes encode() can write for a frame of pixelCount pixels
+    static size_t maxEncodedSize(size_t pixelCount);
+
+    // Encodes pixels, all below 1 << minCodeSize, as GIF image data: the data sub-blocks and
+    // the block terminator that follow the minimum code size byte. out must hold
+    // maxEncodedSize(count) bytes. Returns the number of bytes written.
+    size_t encode(const uint8_t *pixels, size_t count, int minCodeSize, uint8_t *out);
+
+private:
+    // One entry per (prefix code, next pixel): the generation it was written in, high bits,
+    // and the code of the longer string, low 12 bits. Kept between frames.
+    std::vector<uint32_t> m_table;
+    uint32_t m_generation = 0;
+};
@@ -0,0 +1,91 @@
+// Written by malekpour-dev.ir
+// LoopTiming picks the frames of an exported loop: as few frames as reproduce the scene's
+// true period on a centisecond clock, the time unit of GIF frame delays.
+
+#include "LoopTiming.h"
+#include <algorithm>
+#include <cmath>
+
+// Browsers play delays under 2 centiseconds at 10, which is far slower
+static const int kMinFrameDelay = 2;
+
+// Drift an item may have at the loop point, well under a frame at any rate we export
+static const double kLoopTolerance = 0.002;
+static const double kMaxLoopSeconds = 30.0;
+
+// Frames for a loop at the frame rate on average, none shorter than the minimum delay
+static int framesFor(int ticks, double fps)
+{
+    int frames = static_cast<int>(std::lround(ticks * fps / 100.0));
+    return std::max(1, std::min(frames, ticks / kMinFrameDelay));
+}
+
+LoopTiming LoopTiming::forScene(const Scene &scene, double fps, bool spreadDelays)
+{
+    LoopTiming timing;
+    fps = fps > 0.0 ? fps : 100.0 / kMinFrameDelay;
+
+    // The longest delay that still plays at no less than the frame rate
+    const int evenDelay = std::max(kMinFrameDelay, static_cast<int>(100.0 / fps));
+
+    double period = scene.loopPeriod(0.01, kLoopTolerance, kMaxLoopSeconds);
+    if (period <= 0.0)
+    {
+        if (!scene.hasAnimatedItems())
+        {
+            // Nothing moves, one frame is the whole animation
+            timing.loopTicks = evenDelay;
+            timing.seamless = true;
+            return timing;
+        }
+
+        // No common period worth rendering, the slowest cycle with a seam where it wraps
+        int ticks = std::max(kMinFrameDelay, static_cast<int>(std::lround(scene.cycleDuration() * 100.0)));
+        timing.frameCount = spreadDelays ? framesFor(ticks, fps) : std::max(1, ticks / evenDelay);
+        timing.loopTicks = spreadDelays ? ticks : timing.frameCount * evenDelay;
+        return timing;
+    }
+
+    const int periodTicks = static_cast<int>(std::lround(period * 100.0));
+    if (spreadDelays)
+    {
+        // Any period of at least one frame works, the delays absorb the rounding
+        timing.loopTicks = periodTicks * ((kMinFrameDelay + periodTicks - 1) / periodTicks);
+        timing.frameCount = framesFor(timing.loopTicks, fps);
+        timing.seamless = true;
+        return timing;
+    }
+
+    // Any multiple of the period loops too. The first one the even delay or a shorter one
+    // divides gives the fewest frames, each exactly on the centisecond clock.
+    for (int ticks = periodTicks; ticks <= kMaxLoopSeconds * 100.0; ticks += periodTicks)
+    {
+        for (int delay = std::min(evenDelay, ticks); delay >= kMinFrameDelay; --delay)
+        {
+            if (ticks % delay == 0)
+            {
+                timing.frameCount = ticks / delay;
+                timing.loopTicks = ticks;
+                timing.seamless = true;
+                return timing;
+            }
+        }
+    }
+
+    // Only an odd period with an even delay of 2 that has no second multiple under the limit
+    timing.frameCount = std::max(1, periodTicks / evenDelay);
+    timing.loopTicks = timing.frameCount * evenDelay;
+    return timing;
+}
+
+int LoopTiming::frameCountAt(const Scene &scene, double fps)
+{
+    if (fps <= 0.0 || !scene.hasAnimatedItems())
+        return 1;
+
+    // Loops of whole frames only, so the last frame leads into the first one at the same step
+    double period = scene.loopPeriod(1.0 / fps, kLoopTolerance, kMaxLoopSeconds);
+    if (period <= 0.0)
+        period = scene.cycleDuration();
+    return std::max(1, static_cast<int>(std::lround(period * fps)));
+}
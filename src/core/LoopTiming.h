@@ -0,0 +1,31 @@
+// Written by malekpour-dev.ir
+// LoopTiming picks the frames of an exported loop: as few frames as reproduce the scene's
+// true period on a centisecond clock, the time unit of GIF frame delays.
+
+#pragma once
+
+#include "Scene.h"
+#include <cstdint>
+
+struct LoopTiming
+{
+    int frameCount = 1;
+    int loopTicks = 2;     // Centiseconds the whole loop lasts
+    bool seamless = false; // False when no common period was found and the loop has a seam
+
+    // Frames start on whole centiseconds. When the frame count does not divide the loop,
+    // delays differ by one and the rounding error never adds up.
+    int frameStart(int frame) const { return static_cast<int>(static_cast<int64_t>(frame) * loopTicks / frameCount); }
+    int frameDelay(int frame) const { return frameStart(frame + 1) - frameStart(frame); }
+    double frameTime(int frame) const { return frameStart(frame) / 100.0; }
+    double duration() const { return loopTicks / 100.0; }
+
+    // Timing for the given frame rate. With spreadDelays the rate is met on average by
+    // mixing delays; otherwise every frame gets the same delay, no longer than the rate's,
+    // which may take more frames or a longer loop.
+    static LoopTiming forScene(const Scene &scene, double fps, bool spreadDelays);
+
+    // Frames of the shortest loop at exactly the given rate, frame k at k / fps, for formats
+    // without a centisecond clock such as image sequences
+    static int frameCountAt(const Scene &scene, double fps);
+};
@@ -0,0 +1,285 @@
+// Written by malekpour-dev.ir
+// PaletteQuantizer builds an indexed palette by median cut over color statistics gathered from
+// any number of frames, and PaletteMap maps frames to it through a precomputed color cube.
+
+#include "PaletteQuantizer.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#define TWIQ_QUANTIZER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// 5 bits per channel, the same precision GIF encoders commonly quantize to
+static const int kCubeBits = 5;
+static const int kCubeSide = 1 << kCubeBits;
+static const int kCubeCells = kCubeSide * kCubeSide * kCubeSide;
+static const int kOpaqueAlpha = 128;
+
+static inline int cubeIndex(int r, int g, int b)
+{
+    return (r << (2 * kCubeBits)) | (g << kCubeBits) | b;
+}
+
+// Cube cell of an ARGB32 pixel, red in the high bits
+static inline int cubeIndex(QRgb pixel)
+{
+    return ((pixel >> 9) & 0x7C00) | ((pixel >> 6) & 0x03E0) | ((pixel >> 3) & 0x001F);
+}
+
+PaletteQuantizer::PaletteQuantizer()
+    : m_counts(kCubeCells, 0), m_sums(kCubeCells * 3, 0)
+{
+}
+
+void PaletteQuantizer::clear()
+{
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    std::fill(m_sums.begin(), m_sums.end(), 0);
+    m_total = 0;
+}
+
+void PaletteQuantizer::addFrame(const QImage &frame, int step)
+{
+    step = std::max(1, step);
+    for (int y = 0; y < frame.height(); y += step)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+        for (int x = 0; x < frame.width(); x += step)
+        {
+            QRgb pixel = line[x];
+            if (qAlpha(pixel) < kOpaqueAlpha)
+                continue;
+
+            int cell = cubeIndex(pixel);
+            m_counts[cell]++;
+            m_sums[cell * 3] += qRed(pixel);
+            m_sums[cell * 3 + 1] += qGreen(pixel);
+            m_sums[cell * 3 + 2] += qBlue(pixel);
+            m_total++;
+        }
+    }
+}
+
+namespace
+{
+struct ColorBox
+{
+    int lo[3];
+    int hi[3]; // Inclusive
+    uint64_t count = 0;
+
+    int longestAxis() const
+    {
+        int axis = 0;
+        for (int i = 1; i < 3; ++i)
+        {
+            if (hi[i] - lo[i] > hi[axis] - lo[axis])
+                axis = i;
+        }
+        return axis;
+    }
+
+    int length(int axis) const { return hi[axis] - lo[axis]; }
+};
+
+template <typename Fn>
+void forEachCell(const ColorBox &box, Fn fn)
+{
+    for (int r = box.lo[0]; r <= box.hi[0]; ++r)
+    {
+        for (int g = box.lo[1]; g <= box.hi[1]; ++g)
+        {
+            for (int b = box.lo[2]; b <= box.hi[2]; ++b)
+            {
+                fn(r, g, b, cubeIndex(r, g, b));
+            }
+        }
+    }
+}
+} // namespace
+
+// Shrinks the box to the cells that hold samples and counts them
+static void tighten(ColorBox &box, const std::vector<uint32_t> &counts)
+{
+    int lo[3] = {kCubeSide, kCubeSide, kCubeSide};
+    int hi[3] = {-1, -1, -1};
+    uint64_t count = 0;
+    forEachCell(box, [&](int r, int g, int b, int cell)
+                {
+        if (!counts[cell])
+            return;
+
+        const int c[3] = {r, g, b};
+        for (int i = 0; i < 3; ++i)
+        {
+            lo[i] = std::min(lo[i], c[i]);
+            hi[i] = std::max(hi[i], c[i]);
+        }
+        count += counts[cell]; });
+
+    std::copy(lo, lo + 3, box.lo);
+    std::copy(hi, hi + 3, box.hi);
+    box.count = count;
+}
+
+QVector<QRgb> PaletteQuantizer::palette(int maxColors) const
+{
+    QVector<QRgb> palette;
+    palette.append(qRgba(0, 0, 0, 0));
+    if (isEmpty())
+        return palette;
+
+    std::vector<ColorBox> boxes(1);
+    boxes[0] = ColorBox{{0, 0, 0}, {kCubeSide - 1, kCubeSide - 1, kCubeSide - 1}};
+    tighten(boxes[0], m_counts);
+
+    std::vector<uint64_t> slices(kCubeSide);
+    while (static_cast<int>(boxes.size()) < maxColors)
+    {
+        // Split where it pays most: many samples spread over a long color range
+        int pick = -1;
+        uint64_t bestScore = 0;
+        for (size_t i = 0; i < boxes.size(); ++i)
+        {
+            const ColorBox &box = boxes[i];
+            uint64_t score = box.count * static_cast<uint64_t>(box.length(box.longestAxis()));
+            if (score > bestScore)
+            {
+                bestScore = score;
+                pick = static_cast<int>(i);
+            }
+        }
+        if (pick < 0)
+            break;
+
+        ColorBox box = boxes[pick];
+        int axis = box.longestAxis();
+
+        std::fill(slices.begin(), slices.end(), 0);
+        forEachCell(box, [&](int r, int g, int b, int cell)
+                    {
+            const int c[3] = {r, g, b};
+            slices[c[axis]] += m_counts[cell]; });
+
+        // Weighted median, both halves keep at least one slice
+        int split = box.lo[axis];
+        uint64_t below = slices[split];
+        while (split < box.hi[axis] - 1 && below * 2 < box.count)
+        {
+            below += slices[++split];
+        }
+
+        ColorBox upper = box;
+        box.hi[axis] = split;
+        upper.lo[axis] = split + 1;
+        tighten(box, m_counts);
+        tighten(upper, m_counts);
+
+        boxes[pick] = box;
+        boxes.push_back(upper);
+    }
+
+    for (const ColorBox &box : boxes)
+    {
+        uint64_t sum[3] = {0, 0, 0};
+        forEachCell(box, [&](int, int, int, int cell)
+                    {
+            for (int i = 0; i < 3; ++i)
+                sum[i] += m_sums[cell * 3 + i]; });
+
+        auto average = [&](int i)
+        {
+            return static_cast<int>((sum[i] + box.count / 2) / box.count);
+        };
+        palette.append(qRgb(average(0), average(1), average(2)));
+    }
+
+    return palette;
+}
+
+PaletteMap::PaletteMap(const QVector<QRgb> &palette)
+    : m_palette(palette), m_cube(kCubeCells, 0)
+{
+    if (palette.size() < 2)
+        return;
+
+    // Nearest opaque color for the center of every cell
+    for (int r = 0; r < kCubeSide; ++r)
+    {
+        for (int g = 0; g < kCubeSide; ++g)
+        {
+            for (int b = 0; b < kCubeSide; ++b)
+            {
+                int cr = (r << 3) | 4;
+                int cg = (g << 3) | 4;
+                int cb = (b << 3) | 4;
+
+                int best = 1;
+                int bestDistance = INT32_MAX;
+                for (int i = 1; i < palette.size(); ++i)
+                {
+                    int dr = qRed(palette[i]) - cr;
+                    int dg = qGreen(palette[i]) - cg;
+                    int db = qBlue(palette[i]) - cb;
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = i;
+                    }
+                }
+                m_cube[cubeIndex(r, g, b)] = static_cast<uint8_t>(best);
+            }
+        }
+    }
+}
+
+void PaletteMap::map(const QImage &frame, QImage &indexed) const
+{
+    if (indexed.size() != frame.size() || indexed.format() != QImage::Format_Indexed8)
+        indexed = QImage(frame.size(), QImage::Format_Indexed8);
+    indexed.setColorTable(m_palette);
+
+    const uint8_t *cube = m_cube.data();
+    const int width = frame.width();
+    for (int y = 0; y < frame.height(); ++y)
+    {
+        const QRgb *in = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+        uchar *out = indexed.scanLine(y);
+        int x = 0;
+
+#ifdef TWIQ_QUANTIZER_SSE2
+        // Cell indices and the transparency test for four pixels at once, the cube lookup
+        // itself stays scalar as SSE2 has no gather
+        const __m128i redMask = _mm_set1_epi32(0x7C00);
+        const __m128i greenMask = _mm_set1_epi32(0x03E0);
+        const __m128i blueMask = _mm_set1_epi32(0x001F);
+        const __m128i opaque = _mm_set1_epi32(kOpaqueAlpha - 1);
+        alignas(16) int32_t cells[4];
+        alignas(16) int32_t visible[4];
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x));
+            __m128i cell = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 9), redMask),
+                             _mm_and_si128(_mm_srli_epi32(pixels, 6), greenMask)),
+                _mm_and_si128(_mm_srli_epi32(pixels, 3), blueMask));
+            __m128i isOpaque = _mm_cmpgt_epi32(_mm_srli_epi32(pixels, 24), opaque);
+            _mm_store_si128(reinterpret_cast<__m128i *>(cells), cell);
+            _mm_store_si128(reinterpret_cast<__m128i *>(visible), isOpaque);
+
+            out[x] = cube[cells[0]] & visible[0];
+            out[x + 1] = cube[cells[1]] & visible[1];
+            out[x + 2] = cube[cells[2]] & visible[2];
+            out[x + 3] = cube[cells[3]] & visible[3];
+        }
+#endif
+
+        for (; x < width; ++x)
+        {
+            QRgb pixel = in[x];
+            out[x] = qAlpha(pixel) < kOpaqueAlpha ? 0 : cube[cubeIndex(pixel)];
+        }
+    }
+}
@@ -0,0 +1,50 @@
+// Written by malekpour-dev.ir
+// PaletteQuantizer builds an indexed palette by median cut over color statistics gathered from
+// any number of frames, and PaletteMap maps frames to it through a precomputed color cube.
+
+#pragma once
+
+#include <QImage>
+#include <QVector>
+#include <cstdint>
+#include <vector>
+
+class PaletteQuantizer
+{
+public:
+    PaletteQuantizer();
+
+    // Adds every step-th pixel of every step-th row of an ARGB32 frame. Pixels under half
+    // alpha are left out, they map to the transparent index anyway.
+    void addFrame(const QImage &frame, int step = 1);
+    void clear();
+    bool isEmpty() const { return m_total == 0; }
+
+    // Median cut of everything added so far. Index 0 is the transparent color, at most
+    // maxColors opaque colors follow.
+    QVector<QRgb> palette(int maxColors = 255) const;
+
+private:
+    std::vector<uint32_t> m_counts; // Per cell of the 32x32x32 color cube
+    std::vector<uint64_t> m_sums;   // Red, green and blue sums per cell, for exact averages
+    uint64_t m_total = 0;
+};
+
+class PaletteMap
+{
+public:
+    PaletteMap() = default;
+
+    // Palette as made by PaletteQuantizer, index 0 is only used for transparent pixels
+    explicit PaletteMap(const QVector<QRgb> &palette);
+
+    const QVector<QRgb> &palette() const { return m_palette; }
+
+    // Maps an ARGB32 frame to palette indices. Pixels under half alpha become index 0.
+    // The indexed image is reused when it already has the right size.
+    void map(const QImage &frame, QImage &indexed) const;
+
+private:
+    QVector<QRgb> m_palette;
+    std::vector<uint8_t> m_cube; // Nearest palette index per cell of the 32x32x32 color cube
+};
@@ -0,0 +1,117 @@
+// Written by malekpour-dev.ir
+// PreviewAtlas renders many small scenes into the tiles of one shared image with one
+// renderer, so a gallery of previews costs a single surface and context per frame.
+
+#include "PreviewAtlas.h"
+#include <algorithm>
+#include <utility>
+
+// Tiles per atlas row, the atlas grows by rows as more previews are on screen at once
+static const int kAtlasColumns = 8;
+
+PreviewAtlas::PreviewAtlas(int tileSize)
+    : m_tileSize(tileSize)
+{
+}
+
+int PreviewAtlas::addScene(Scene scene)
+{
+    m_scenes.push_back(std::move(scene));
+    m_slotOfPreview.push_back(-1);
+    m_wanted.push_back(0);
+    return static_cast<int>(m_scenes.size() - 1);
+}
+
+BLRectI PreviewAtlas::slotRect(int slot) const
+{
+    return BLRectI((slot % kAtlasColumns) * m_tileSize, (slot / kAtlasColumns) * m_tileSize, m_tileSize, m_tileSize);
+}
+
+bool PreviewAtlas::tileOf(int preview, BLRectI &tile) const
+{
+    int slot = m_slotOfPreview[preview];
+    if (slot < 0)
+        return false;
+
+    tile = slotRect(slot);
+    return true;
+}
+
+void PreviewAtlas::render(const std::vector<int> &previews, double time)
+{
+    std::fill(m_wanted.begin(), m_wanted.end(), 0);
+    for (int preview : previews)
+    {
+        m_wanted[preview] = 1;
+    }
+
+    // Previews that left the screen give their tiles back
+    for (size_t slot = 0; slot < m_previewOfSlot.size(); ++slot)
+    {
+        int preview = m_previewOfSlot[slot];
+        if (preview >= 0 && !m_wanted[preview])
+        {
+            m_slotOfPreview[preview] = -1;
+            m_previewOfSlot[slot] = -1;
+        }
+    }
+
+    size_t nextFree = 0;
+    for (int preview : previews)
+    {
+        if (m_slotOfPreview[preview] >= 0)
+            continue;
+
+        while (nextFree < m_previewOfSlot.size() && m_previewOfSlot[nextFree] >= 0)
+        {
+            ++nextFree;
+        }
+        if (nextFree == m_previewOfSlot.size())
+        {
+            m_previewOfSlot.push_back(-1);
+            m_slotDrawn.push_back(0);
+        }
+
+        m_previewOfSlot[nextFree] = preview;
+        m_slotOfPreview[preview] = static_cast<int>(nextFree);
+        m_slotDrawn[nextFree] = 0;
+    }
+
+    int rows = (static_cast<int>(m_previewOfSlot.size()) + kAtlasColumns - 1) / kAtlasColumns;
+    int width = kAtlasColumns * m_tileSize;
+    int height = rows * m_tileSize;
+    if (height == 0)
+        return;
+
+    if (m_image.width() != width || m_image.height() != height)
+    {
+        m_image.create(width, height, BL_FORMAT_PRGB32);
+        std::fill(m_slotDrawn.begin(), m_slotDrawn.end(), 0);
+    }
+
+    BLContext ctx(m_image, m_renderer.createInfo(width, height));
+    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+
+    for (int preview : previews)
+    {
+        int slot = m_slotOfPreview[preview];
+        const Scene &scene = m_scenes[preview];
+        if (m_slotDrawn[slot] && !scene.hasAnimatedItems())
+            continue;
+
+        BLRectI tile = slotRect(slot);
+
+        // The tile offset goes into the meta transform, items replace the user transform
+        ctx.save();
+        ctx.translate(tile.x, tile.y);
+        ctx.userToMeta();
+        ctx.clipToRect(BLRectI(0, 0, m_tileSize, m_tileSize));
+        ctx.clearRect(BLRectI(0, 0, m_tileSize, m_tileSize));
+        m_renderer.drawScene(ctx, scene, time);
+        ctx.restore();
+
+        m_slotDrawn[slot] = 1;
+    }
+
+    ctx.end();
+}
@@ -0,0 +1,43 @@
+// Written by malekpour-dev.ir
+// PreviewAtlas renders many small scenes into the tiles of one shared image with one
+// renderer, so a gallery of previews costs a single surface and context per frame.
+
+#pragma once
+
+#include <blend2d.h>
+#include <vector>
+#include "Scene.h"
+#include "SceneRenderer.h"
+
+class PreviewAtlas
+{
+public:
+    explicit PreviewAtlas(int tileSize);
+
+    int tileSize() const { return m_tileSize; }
+
+    // Scenes are rendered at tile size, returns the preview index
+    int addScene(Scene scene);
+    size_t size() const { return m_scenes.size(); }
+    const Scene &scene(int preview) const { return m_scenes[preview]; }
+
+    // Renders the given previews at the scene time. Only these previews hold a tile
+    // afterwards, tiles of the others are handed out again.
+    void render(const std::vector<int> &previews, double time);
+
+    // Where the last render() put the preview, false when it has no tile
+    bool tileOf(int preview, BLRectI &tile) const;
+    const BLImage &image() const { return m_image; }
+
+private:
+    BLRectI slotRect(int slot) const;
+
+    int m_tileSize;
+    std::vector<Scene> m_scenes;
+    std::vector<int> m_slotOfPreview;  // -1 without a tile
+    std::vector<int> m_previewOfSlot;  // -1 for a free tile
+    std::vector<char> m_slotDrawn;     // Tile holds its preview, static previews are drawn once
+    std::vector<char> m_wanted;
+    BLImage m_image;
+    SceneRenderer m_renderer;
+};
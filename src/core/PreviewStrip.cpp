@@ -0,0 +1,82 @@
+// Written by malekpour-dev.ir
+// PreviewStrip is one loop of a scene pre-rendered into a vertical strip of square frames,
+// so a preview plays back by blitting frames instead of rendering the scene again.
+
+#include "PreviewStrip.h"
+#include <algorithm>
+#include <cmath>
+#include "LoopTiming.h"
+#include "SceneRenderer.h"
+
+int PreviewStrip::loopFrameCount(const Scene &scene, int fps, int maxFrames)
+{
+    // The common period of all items, the slowest cycle alone seams when the others do not divide it
+    return std::clamp(LoopTiming::frameCountAt(scene, fps), 1, std::max(1, maxFrames));
+}
+
+PreviewStrip PreviewStrip::render(const Scene &scene, int frameSize, int fps, int frameCount)
+{
+    frameCount = std::max(1, frameCount);
+
+    PreviewStrip strip;
+    strip.m_frameSize = frameSize;
+    strip.m_frameCount = frameCount;
+    strip.m_fps = fps;
+    strip.m_frames = QImage(frameSize, frameSize * frameCount, QImage::Format_ARGB32_Premultiplied);
+    strip.m_frames.fill(Qt::transparent);
+
+    BLImage blImage;
+    blImage.createFromData(
+        strip.m_frames.width(),
+        strip.m_frames.height(),
+        BL_FORMAT_PRGB32,
+        strip.m_frames.bits(),
+        strip.m_frames.bytesPerLine(),
+        BL_DATA_ACCESS_RW,
+        nullptr,
+        nullptr);
+
+    // Renderers cache shapes and are not shared, every strip gets its own. Strips already
+    // render in parallel on the cache's pool, Blend2D workers on top would oversubscribe it.
+    SceneRenderer renderer;
+    renderer.setThreadCount(1);
+    BLContext ctx(blImage, renderer.createInfo(blImage.width(), blImage.height()));
+    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        ctx.save();
+        ctx.translate(0, frame * frameSize);
+        ctx.userToMeta();
+        ctx.clipToRect(BLRectI(0, 0, frameSize, frameSize));
+        renderer.drawScene(ctx, scene, static_cast<double>(frame) / fps);
+        ctx.restore();
+    }
+
+    ctx.end();
+    return strip;
+}
+
+PreviewStrip PreviewStrip::fromImage(const QImage &image, int frameSize, int fps)
+{
+    PreviewStrip strip;
+    if (image.isNull() || frameSize <= 0 || image.width() != frameSize || image.height() % frameSize != 0)
+        return strip;
+
+    strip.m_frames = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    strip.m_frameSize = frameSize;
+    strip.m_frameCount = image.height() / frameSize;
+    strip.m_fps = fps;
+    return strip;
+}
+
+QRect PreviewStrip::frameRect(double time) const
+{
+    if (m_frameCount <= 1)
+        return QRect(0, 0, m_frameSize, m_frameSize);
+
+    long long frame = static_cast<long long>(std::floor(time * m_fps)) % m_frameCount;
+    if (frame < 0)
+        frame += m_frameCount;
+    return QRect(0, static_cast<int>(frame) * m_frameSize, m_frameSize, m_frameSize);
+}
@@ -0,0 +1,38 @@
+// Written by malekpour-dev.ir
+// PreviewStrip is one loop of a scene pre-rendered into a vertical strip of square frames,
+// so a preview plays back by blitting frames instead of rendering the scene again.
+
+#pragma once
+
+#include <QImage>
+#include <QRect>
+#include "Scene.h"
+
+class PreviewStrip
+{
+public:
+    PreviewStrip() = default;
+
+    // Frames of the scene's shortest seamless loop at the given frame rate, at most maxFrames
+    static int loopFrameCount(const Scene &scene, int fps, int maxFrames);
+
+    // Renders frameCount frames of the scene from time 0 at the given frame rate
+    static PreviewStrip render(const Scene &scene, int frameSize, int fps, int frameCount);
+
+    // Wraps a strip loaded back from disk, null when the image is not a strip of that frame size
+    static PreviewStrip fromImage(const QImage &image, int frameSize, int fps);
+
+    bool isNull() const { return m_frames.isNull(); }
+    int frameSize() const { return m_frameSize; }
+    int frameCount() const { return m_frameCount; }
+    const QImage &image() const { return m_frames; }
+
+    // Part of image() showing the loop at the given time
+    QRect frameRect(double time) const;
+
+private:
+    QImage m_frames;
+    int m_frameSize = 0;
+    int m_frameCount = 0;
+    int m_fps = 0;
+};
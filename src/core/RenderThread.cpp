@@ -0,0 +1,324 @@
+// Written by malekpour-dev.ir
+// RenderThread rasterizes canvas frames away from the GUI thread. It draws immutable scene
+// snapshots and publishes finished frames through a triple buffer, the GUI only blits them.
+
+#include "RenderThread.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+static BLBox toBox(const QRect &rect)
+{
+    return BLBox(rect.left(), rect.top(), rect.left() + rect.width(), rect.top() + rect.height());
+}
+
+RenderThread::RenderThread(QObject *parent)
+    : QThread(parent)
+{
+}
+
+RenderThread::~RenderThread()
+{
+    stop();
+}
+
+void RenderThread::submit(RenderRequest request)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_request = std::move(request);
+        m_hasRequest = true;
+    }
+    m_wake.wakeOne();
+
+    if (!isRunning())
+        start();
+}
+
+void RenderThread::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+    }
+    m_wake.wakeOne();
+    wait();
+}
+
+const QImage &RenderThread::latestFrame()
+{
+    m_frames.acquire();
+    return m_frames.front().image;
+}
+
+void RenderThread::run()
+{
+    for (;;)
+    {
+        RenderRequest request;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_hasRequest && !m_quit)
+            {
+                m_wake.wait(&m_mutex);
+            }
+            if (m_quit)
+                return;
+
+            request = std::move(m_request);
+            m_request = RenderRequest();
+            m_hasRequest = false;
+        }
+
+        if (request.scene && request.width > 0 && request.height > 0)
+        {
+            QRegion damage = renderFrame(request);
+            if (!damage.isEmpty())
+                emit frameReady(damage);
+        }
+        emit requestDone();
+    }
+}
+
+QRegion RenderThread::renderFrame(const RenderRequest &request)
+{
+    const Scene &scene = *request.scene;
+    const QRect frameRect(0, 0, request.width, request.height);
+
+    bool resized = request.width != m_width || request.height != m_height;
+    if (resized)
+    {
+        m_width = request.width;
+        m_height = request.height;
+        m_staticLayer.resize(m_width, m_height);
+        m_damage.resize(m_width, m_height);
+        m_paintStates.clear();
+    }
+
+    m_renderer.setThreadCount(request.threadCount);
+
+    // Poses of every item at this time in one batch
+    m_evaluator.evaluate(scene, request.time);
+
+    std::vector<QRect> paintRects;
+    QRegion damage = frameDamage(request, paintRects);
+    if (resized)
+        damage = frameRect;
+    m_lastScene = request.scene;
+
+    // Nothing changed, the last published frame is still current
+    if (damage.isEmpty())
+        return damage;
+
+    // Every slot misses this frame's changes until it is drawn again. The back slot also
+    // catches up on the frames published through the other slots since it was last drawn.
+    for (QRegion &pending : m_pendingDamage)
+    {
+        pending += damage;
+    }
+
+    Frame &frame = m_frames.back();
+    QRegion &pending = m_pendingDamage[m_frames.backIndex()];
+    if (frame.image.width() != m_width || frame.image.height() != m_height)
+    {
+        // Same memory layout as BL_FORMAT_PRGB32, so QPainter blits it without a conversion
+        frame.image = QImage(m_width, m_height, QImage::Format_ARGB32_Premultiplied);
+        frame.target.createFromData(
+            frame.image.width(),
+            frame.image.height(),
+            BL_FORMAT_PRGB32,
+            frame.image.bits(),
+            frame.image.bytesPerLine(),
+            BL_DATA_ACCESS_RW,
+            nullptr,
+            nullptr);
+        pending = frameRect;
+    }
+    pending &= frameRect;
+
+    // Static items come from the cached layer, only animating ones are rasterized per frame.
+    // The selected item stays live so editing it does not keep rebuilding the cache.
+    m_staticLayer.update(scene, m_evaluator, m_renderer, request.selectedId);
+
+    // Indexed by position in the scene, so the candidates of a rect sort back into z-order
+    const auto &items = scene.items();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        m_paintIndex.update(static_cast<int>(i), toBox(paintRects[i]));
+    }
+    for (size_t i = items.size(); i < m_indexedItems; ++i)
+    {
+        m_paintIndex.remove(static_cast<int>(i));
+    }
+    m_indexedItems = items.size();
+
+    BLContext ctx(frame.target, m_renderer.createInfo(m_width, m_height));
+    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+
+    // Blend2D only clips to rectangles, so an item is drawn once per damaged rect it
+    // touches, and each rect only looks at the items the index finds under it
+    for (const QRect &rect : pending)
+    {
+        BLRectI clip(rect.x(), rect.y(), rect.width(), rect.height());
+        ctx.clipToRect(clip);
+        m_staticLayer.composite(ctx, clip);
+
+        m_drawCandidates.clear();
+        m_paintIndex.query(toBox(rect), m_drawCandidates);
+        std::sort(m_drawCandidates.begin(), m_drawCandidates.end());
+
+        for (int i : m_drawCandidates)
+        {
+            if (m_staticLayer.isCached(i))
+                continue;
+
+            m_renderer.drawItem(ctx, items[i], m_evaluator.transform(i), m_evaluator.alpha(i));
+
+            if (items[i].id == request.selectedId)
+            {
+                ctx.resetTransform();
+                drawSelectionBox(ctx, items[i], request.time);
+            }
+        }
+
+        ctx.resetTransform();
+        ctx.restoreClipping();
+    }
+
+    ctx.end();
+    pending = QRegion();
+
+    m_frames.publish();
+    return damage;
+}
+
+QRegion RenderThread::frameDamage(const RenderRequest &request, std::vector<QRect> &paintRects)
+{
+    const Scene &scene = *request.scene;
+    const auto &items = scene.items();
+    bool sceneChanged = request.scene != m_lastScene;
+
+    paintRects.clear();
+    paintRects.reserve(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const SpinnerItem &item = items[i];
+        QRect rect = itemPaintRect(item, m_evaluator.bounds(i), request);
+        paintRects.push_back(rect);
+
+        auto painted = m_paintStates.constFind(item.id);
+        if (painted == m_paintStates.constEnd())
+        {
+            m_damage.add(rect);
+            continue;
+        }
+
+        // The static layer cannot tell that e.g. the color changed, drop both areas explicitly
+        bool edited = false;
+        if (sceneChanged)
+        {
+            const SpinnerItem *before = m_lastScene ? m_lastScene->findItem(item.id) : nullptr;
+            edited = !before || !sameLook(*before, item);
+            if (edited)
+            {
+                m_staticLayer.invalidate(toBox(painted->rect));
+                m_staticLayer.invalidate(toBox(rect));
+            }
+        }
+
+        // Items that were static when drawn and still are cost nothing this frame
+        if (edited || m_evaluator.isAnimating(i) || painted->animating || rect != painted->rect)
+        {
+            m_damage.add(painted->rect);
+            m_damage.add(rect);
+        }
+    }
+
+    // Items removed since the last frame leave their area behind
+    if (sceneChanged)
+    {
+        for (auto it = m_paintStates.constBegin(); it != m_paintStates.constEnd(); ++it)
+        {
+            if (!scene.findItem(it.key()))
+                m_damage.add(it->rect);
+        }
+    }
+
+    m_paintStates.clear();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        m_paintStates.insert(items[i].id, {paintRects[i], m_evaluator.isAnimating(i)});
+    }
+
+    // Every rect marked a few tiles, the region is built from them once
+    return m_damage.takeRegion();
+}
+
+QRect RenderThread::itemPaintRect(const SpinnerItem &item, const BLBox &box, const RenderRequest &request) const
+{
+    QRectF bounds(box.x0, box.y0, box.x1 - box.x0, box.y1 - box.y0);
+
+    if (item.id == request.selectedId)
+    {
+        // Half of the 2px selection stroke lies outside the box
+        bounds = bounds.united(selectionRect(item, request.time).adjusted(-1.0, -1.0, 1.0, 1.0));
+    }
+
+    return bounds.toAlignedRect();
+}
+
+bool RenderThread::sameLook(const SpinnerItem &a, const SpinnerItem &b)
+{
+    // QPointF compares fuzzily, a small drag must still count as a change
+    return a.type == b.type && a.anim == b.anim && a.position.x() == b.position.x() &&
+           a.position.y() == b.position.y() && a.size == b.size && a.rgba.value == b.rgba.value && a.speed == b.speed && a.duration == b.duration &&
+           a.preDelay == b.preDelay && a.postDelay == b.postDelay;
+}
+
+QRectF RenderThread::selectionRect(const SpinnerItem &item, double time)
+{
+    double baseSize = item.size;
+    double padding = 10.0;
+
+    double actualSize = baseSize;
+    if (item.anim == SpinnerAnimation::Scale)
+    {
+        float cyclePosition = Scene::cyclePosition(item, time);
+        if (cyclePosition >= item.preDelay && cyclePosition < (item.preDelay + item.duration))
+        {
+            float normalizedTime = (cyclePosition - item.preDelay) / item.duration;
+            float scale = 0.5f + 0.5f * (1.0f + std::sin(normalizedTime * 2.0f * M_PI));
+            actualSize = baseSize * scale;
+        }
+    }
+
+    switch (item.type)
+    {
+    case SpinnerType::Star:
+        actualSize = std::max(actualSize, baseSize * 1.2);
+        break;
+    case SpinnerType::Triangle:
+        actualSize = std::max(actualSize, baseSize * 1.1);
+        break;
+    default:
+        break;
+    }
+
+    double finalSize = actualSize + padding;
+
+    return QRectF(item.position.x() - finalSize / 2,
+                  item.position.y() - finalSize / 2,
+                  finalSize,
+                  finalSize);
+}
+
+void RenderThread::drawSelectionBox(BLContext &ctx, const SpinnerItem &item, double time)
+{
+    QRectF rect = selectionRect(item, time);
+
+    BLRgba32 selectionColor(100, 150, 255, 128);
+    ctx.setStrokeStyle(selectionColor);
+    ctx.setStrokeWidth(2.0);
+
+    ctx.strokeRect(rect.x(), rect.y(), rect.width(), rect.height());
+}
@@ -0,0 +1,102 @@
+// Written by malekpour-dev.ir
+// RenderThread rasterizes canvas frames away from the GUI thread. It draws immutable scene
+// snapshots and publishes finished frames through a triple buffer, the GUI only blits them.
+
+#pragma once
+
+#include <QImage>
+#include <QHash>
+#include <QMutex>
+#include <QRegion>
+#include <QThread>
+#include <QWaitCondition>
+#include <blend2d.h>
+#include <memory>
+#include "AnimationEvaluator.h"
+#include "DamageGrid.h"
+#include "Scene.h"
+#include "SceneRenderer.h"
+#include "SpatialIndex.h"
+#include "StaticLayer.h"
+#include "TripleBuffer.h"
+
+struct RenderRequest
+{
+    std::shared_ptr<const Scene> scene; // Never modified once submitted
+    double time = 0.0;
+    int width = 0;
+    int height = 0;
+    int selectedId = -1; // Drawn with a selection box and kept out of the static layer
+    int threadCount = 0; // See SceneRenderer::setThreadCount()
+};
+
+class RenderThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit RenderThread(QObject *parent = nullptr);
+    ~RenderThread();
+
+    // Replaces a request that was not started yet, the thread always renders the newest one
+    void submit(RenderRequest request);
+    void stop();
+
+    // GUI thread only. The newest complete frame, null before the first one.
+    const QImage &latestFrame();
+
+    // Area a selection box covers around the item at the given time
+    static QRectF selectionRect(const SpinnerItem &item, double time);
+
+signals:
+    // A frame was published, the region is where it differs from the previous one
+    void frameReady(const QRegion &damage);
+
+    // The thread took a request and is done with it, whether or not it published a frame
+    void requestDone();
+
+protected:
+    void run() override;
+
+private:
+    struct Frame
+    {
+        QImage image;
+        BLImage target; // Shares the pixels of image
+    };
+
+    // Area each item covered when it was last rendered and whether it was animating then
+    struct PaintState
+    {
+        QRect rect;
+        bool animating = false;
+    };
+
+    QRegion renderFrame(const RenderRequest &request);
+    QRegion frameDamage(const RenderRequest &request, std::vector<QRect> &paintRects);
+    QRect itemPaintRect(const SpinnerItem &item, const BLBox &bounds, const RenderRequest &request) const;
+    static void drawSelectionBox(BLContext &ctx, const SpinnerItem &item, double time);
+    static bool sameLook(const SpinnerItem &a, const SpinnerItem &b);
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    RenderRequest m_request;
+    bool m_hasRequest = false;
+    bool m_quit = false;
+
+    TripleBuffer<Frame> m_frames;
+
+    // Render thread only
+    SceneRenderer m_renderer;
+    AnimationEvaluator m_evaluator;
+    StaticLayer m_staticLayer;
+    QHash<int, PaintState> m_paintStates;
+    DamageGrid m_damage;
+    SpatialIndex m_paintIndex; // Paint rects by index into the scene's items
+    size_t m_indexedItems = 0;
+    std::vector<int> m_drawCandidates;
+    std::shared_ptr<const Scene> m_lastScene;
+    QRegion m_pendingDamage[3]; // Per frame slot, what changed since that slot was last drawn
+    int m_width = 0;
+    int m_height = 0;
+};
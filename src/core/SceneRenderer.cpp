@@ -0,0 +1,245 @@
+// Written by malekpour-dev.ir
+// SceneRenderer rasterizes a Scene at a given time with Blend2D.
+// It does not need a widget or a QApplication, so it also runs headless.
+
+#include "SceneRenderer.h"
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+// Below this many pixels the cost of handing work to Blend2D worker threads outweighs the gain
+static const int kAutoThreadingMinPixels = 512 * 512;
+
+void SceneRenderer::setThreadCount(int threadCount)
+{
+    m_threadCount = std::max(0, threadCount);
+}
+
+int SceneRenderer::workerThreadsFor(int width, int height) const
+{
+    if (m_threadCount == 1)
+        return 0;
+    if (m_threadCount > 1)
+        return m_threadCount;
+
+    if (static_cast<qint64>(width) * height < kAutoThreadingMinPixels)
+        return 0;
+
+    int cores = QThread::idealThreadCount();
+    return cores > 1 ? cores : 0;
+}
+
+BLContextCreateInfo SceneRenderer::createInfo(int width, int height) const
+{
+    BLContextCreateInfo info{};
+    info.threadCount = static_cast<uint32_t>(workerThreadsFor(width, height));
+    return info;
+}
+
+QString SceneRenderer::threadingDescription(int width, int height) const
+{
+    int workers = workerThreadsFor(width, height);
+    QString mode = workers == 0 ? QString("single-threaded") : QString("%1 threads").arg(workers);
+    return m_threadCount == 0 ? QString("%1 (auto)").arg(mode) : mode;
+}
+
+void SceneRenderer::render(const Scene &scene, double time, BLImage &target)
+{
+    BLContext ctx(target, createInfo(target.width(), target.height()));
+    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+    ctx.clearAll();
+
+    // Drawn at the target's resolution, not scaled up from a scene sized image afterwards
+    if (scene.width() > 0 && scene.height() > 0 &&
+        (target.width() != scene.width() || target.height() != scene.height()))
+    {
+        ctx.scale(static_cast<double>(target.width()) / scene.width(),
+                  static_cast<double>(target.height()) / scene.height());
+        ctx.userToMeta();
+    }
+
+    drawScene(ctx, scene, time);
+
+    ctx.end();
+}
+
+void SceneRenderer::drawScene(BLContext &ctx, const Scene &scene, double time)
+{
+    m_evaluator.evaluate(scene, time);
+
+    const auto &items = scene.items();
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        if (!m_evaluator.isVisible(i))
+            continue;
+        drawItem(ctx, items[i], m_evaluator.transform(i), m_evaluator.alpha(i));
+    }
+
+    ctx.resetTransform();
+}
+
+void SceneRenderer::drawItem(BLContext &ctx, const SpinnerItem &item, double time)
+{
+    AnimationEvaluator::Pose pose = AnimationEvaluator::evaluateItem(item, time);
+    drawItem(ctx, item, pose.transform, pose.alpha);
+}
+
+BLMatrix2D SceneRenderer::itemTransform(const SpinnerItem &item, double time)
+{
+    return AnimationEvaluator::evaluateItem(item, time).transform;
+}
+
+bool SceneRenderer::isAnimating(const SpinnerItem &item, double time)
+{
+    return AnimationEvaluator::evaluateItem(item, time).animating;
+}
+
+BLBox SceneRenderer::itemBounds(const SpinnerItem &item, double time)
+{
+    // Stars reach out to item.size from the center, every other shape to half of it
+    double extent = item.type == SpinnerType::Star ? item.size : item.size / 2.0;
+    BLMatrix2D transform = itemTransform(item, time);
+
+    const BLPoint corners[4] = {
+        transform.mapPoint(-extent, -extent),
+        transform.mapPoint(extent, -extent),
+        transform.mapPoint(extent, extent),
+        transform.mapPoint(-extent, extent)};
+
+    BLBox box(corners[0].x, corners[0].y, corners[0].x, corners[0].y);
+    for (const BLPoint &corner : corners)
+    {
+        box.x0 = std::min(box.x0, corner.x);
+        box.y0 = std::min(box.y0, corner.y);
+        box.x1 = std::max(box.x1, corner.x);
+        box.y1 = std::max(box.y1, corner.y);
+    }
+
+    // One extra pixel for anti-aliased edges
+    return BLBox(box.x0 - 1.0, box.y0 - 1.0, box.x1 + 1.0, box.y1 + 1.0);
+}
+
+BLBox SceneRenderer::sweptBounds(const SpinnerItem &item)
+{
+    double extent = item.type == SpinnerType::Star ? item.size : item.size / 2.0;
+    double left = extent, right = extent, top = extent, bottom = extent;
+
+    // Limits of the offsets applied by the animation functions below
+    switch (item.anim)
+    {
+    case SpinnerAnimation::None:
+    case SpinnerAnimation::Fade:
+        break;
+    case SpinnerAnimation::Rotate:
+        left = right = top = bottom = extent * M_SQRT2;
+        break;
+    case SpinnerAnimation::Scale:
+        left = right = top = bottom = extent * 1.5;
+        break;
+    case SpinnerAnimation::Bounce:
+        left = right = extent * 1.2;
+        top = extent + 20.0;
+        break;
+    case SpinnerAnimation::Slide:
+        left = right = extent + 20.0;
+        break;
+    }
+
+    double x = item.position.x();
+    double y = item.position.y();
+    return BLBox(x - left - 1.0, y - top - 1.0, x + right + 1.0, y + bottom + 1.0);
+}
+
+bool SceneRenderer::hitTest(const SpinnerItem &item, double time, const BLPoint &point)
+{
+    BLMatrix2D inverse = itemTransform(item, time);
+    if (inverse.invert() != BL_SUCCESS)
+        return false;
+
+    // Test in the item's own coordinates, where the shape is centered on the origin
+    BLPoint local = inverse.mapPoint(point);
+    double half = item.size / 2.0;
+
+    switch (item.type)
+    {
+    case SpinnerType::Circle:
+        return local.x * local.x + local.y * local.y <= half * half;
+    case SpinnerType::Rectangle:
+    case SpinnerType::Square:
+        return std::abs(local.x) <= half && std::abs(local.y) <= half;
+    case SpinnerType::Ring:
+    case SpinnerType::Star:
+    case SpinnerType::Triangle:
+        break;
+    }
+
+    return ShapeCache::buildPath(item.type, item.size).hitTest(local, BL_FILL_RULE_NON_ZERO) != BL_HIT_TEST_OUT;
+}
+
+template <SpinnerType Type>
+void SceneRenderer::fillShape(BLContext &ctx, int size)
+{
+    if constexpr (Type == SpinnerType::Circle)
+    {
+        ctx.fillCircle(0, 0, size / 2.0f);
+    }
+    else if constexpr (Type == SpinnerType::Rectangle || Type == SpinnerType::Square)
+    {
+        double w = size;
+        double h = size;
+
+        ctx.fillRect(-w / 2.0, -h / 2.0, w, h);
+    }
+    else
+    {
+        ctx.fillPath(m_shapes.path(Type, size));
+    }
+}
+
+template <SpinnerType Type, SpinnerAnimation Anim>
+void SceneRenderer::drawKernel(SceneRenderer &renderer, BLContext &ctx, const SpinnerItem &item,
+                               const BLMatrix2D &transform, uint8_t alpha)
+{
+    // Replaces the previous item's transform, so no save()/restore() per item
+    ctx.setTransform(transform);
+
+    if constexpr (Anim == SpinnerAnimation::Fade)
+    {
+        // Keep the resolved RGB and only replace the alpha channel
+        ctx.setFillStyle(BLRgba32((item.rgba.value & 0x00FFFFFFu) | (static_cast<uint32_t>(alpha) << 24)));
+    }
+    else
+    {
+        // Only Fade changes the alpha, every other animation draws the color as is
+        ctx.setFillStyle(item.rgba);
+    }
+
+    renderer.fillShape<Type>(ctx, item.size);
+}
+
+SceneRenderer::DrawKernel SceneRenderer::kernel(SpinnerType type, SpinnerAnimation anim)
+{
+    using Row = std::array<DrawKernel, 6>;
+
+    // Columns follow the SpinnerAnimation order
+    auto row = [](auto shape) -> Row
+    {
+        constexpr SpinnerType Type = decltype(shape)::value;
+        return {&drawKernel<Type, SpinnerAnimation::None>, &drawKernel<Type, SpinnerAnimation::Rotate>,
+                &drawKernel<Type, SpinnerAnimation::Scale>, &drawKernel<Type, SpinnerAnimation::Fade>,
+                &drawKernel<Type, SpinnerAnimation::Bounce>, &drawKernel<Type, SpinnerAnimation::Slide>};
+    };
+
+    // Rows follow the SpinnerType order
+    static const std::array<Row, 6> kernels = {
+        row(std::integral_constant<SpinnerType, SpinnerType::Circle>()),
+        row(std::integral_constant<SpinnerType, SpinnerType::Ring>()),
+        row(std::integral_constant<SpinnerType, SpinnerType::Square>()),
+        row(std::integral_constant<SpinnerType, SpinnerType::Rectangle>()),
+        row(std::integral_constant<SpinnerType, SpinnerType::Triangle>()),
+        row(std::integral_constant<SpinnerType, SpinnerType::Star>())};
+
+    return kernels[static_cast<size_t>(type)][static_cast<size_t>(anim)];
+}
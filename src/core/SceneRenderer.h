@@ -0,0 +1,76 @@
+// Written by malekpour-dev.ir
+// SceneRenderer rasterizes a Scene at a given time with Blend2D.
+// It does not need a widget or a QApplication, so it also runs headless.
+
+#pragma once
+
+#include <blend2d.h>
+#include <QString>
+#include "AnimationEvaluator.h"
+#include "Scene.h"
+#include "ShapeCache.h"
+
+class SceneRenderer
+{
+public:
+    // Render threads: 0 picks automatically from the target size, 1 rasterizes synchronously
+    // on the calling thread, anything higher is the number of Blend2D worker threads
+    void setThreadCount(int threadCount);
+    int threadCount() const { return m_threadCount; }
+
+    // Worker threads used for a target of the given size, 0 means synchronous
+    int workerThreadsFor(int width, int height) const;
+    BLContextCreateInfo createInfo(int width, int height) const;
+    QString threadingDescription(int width, int height) const;
+
+    // Clears the target to transparent and draws every item of the scene at the given scene time,
+    // scaled to fill the target when it is not the scene's size
+    void render(const Scene &scene, double time, BLImage &target);
+
+    // Draws every item into a context the caller has already prepared. All poses are
+    // computed up front in one AnimationEvaluator batch, items outside the scene are skipped.
+    void drawScene(BLContext &ctx, const Scene &scene, double time);
+    void drawItem(BLContext &ctx, const SpinnerItem &item, double time);
+
+    // Draws an item with a pose computed elsewhere, e.g. by an AnimationEvaluator.
+    // Items draw without save()/restore(): each one replaces the user transform with its own
+    // and leaves it there, so call resetTransform() before drawing in scene coordinates again.
+    // Scaling the whole scene goes through the meta transform (userToMeta()).
+    void drawItem(BLContext &ctx, const SpinnerItem &item, const BLMatrix2D &transform, uint8_t alpha)
+    {
+        kernel(item.type, item.anim)(*this, ctx, item, transform, alpha);
+    }
+
+    // Placement of the item at the given scene time: its position plus the animation offset
+    static BLMatrix2D itemTransform(const SpinnerItem &item, double time);
+
+    // True while the item is inside its animated phase; false during delays or without animation
+    static bool isAnimating(const SpinnerItem &item, double time);
+
+    // Box around everything drawItem() touches at the given time, anti-aliasing included
+    static BLBox itemBounds(const SpinnerItem &item, double time);
+
+    // Box around every pose the item can take over its whole animation cycle
+    static BLBox sweptBounds(const SpinnerItem &item);
+
+    // True when the point, in scene pixels, lies on the shape as drawn at the given time
+    static bool hitTest(const SpinnerItem &item, double time, const BLPoint &point);
+
+private:
+    using DrawKernel = void (*)(SceneRenderer &renderer, BLContext &ctx, const SpinnerItem &item,
+                                const BLMatrix2D &transform, uint8_t alpha);
+
+    // One kernel per shape and animation pair, each compiled with both known up front
+    static DrawKernel kernel(SpinnerType type, SpinnerAnimation anim);
+
+    template <SpinnerType Type, SpinnerAnimation Anim>
+    static void drawKernel(SceneRenderer &renderer, BLContext &ctx, const SpinnerItem &item,
+                           const BLMatrix2D &transform, uint8_t alpha);
+
+    template <SpinnerType Type>
+    void fillShape(BLContext &ctx, int size);
+
+    int m_threadCount = 0;
+    ShapeCache m_shapes;
+    AnimationEvaluator m_evaluator;
+};
@@ -0,0 +1,79 @@
+// Written by malekpour-dev.ir
+// ShapeCache keeps prebuilt Blend2D paths for shapes that are more than a single
+// primitive (ring, star, triangle), so they are built once per size instead of every frame.
+
+#include "ShapeCache.h"
+#include <cmath>
+
+// Sizes change while a slider is dragged, drop everything rather than grow forever
+static const size_t kMaxCachedPaths = 512;
+
+const BLPath &ShapeCache::path(SpinnerType type, int size)
+{
+    uint64_t key = (static_cast<uint64_t>(type) << 32) | static_cast<uint32_t>(size);
+
+    auto it = m_paths.find(key);
+    if (it != m_paths.end())
+        return it->second;
+
+    if (m_paths.size() >= kMaxCachedPaths)
+        m_paths.clear();
+
+    return m_paths.emplace(key, buildPath(type, size)).first->second;
+}
+
+BLPath ShapeCache::buildPath(SpinnerType type, int size)
+{
+    BLPath path;
+
+    switch (type)
+    {
+    case SpinnerType::Ring:
+    {
+        double outerRadius = size / 2.0;
+        double innerRadius = outerRadius * 0.6;
+
+        // Opposite winding punches the hole under the non-zero fill rule, so the ring
+        // no longer needs DST_OUT, which also erased whatever was drawn below it
+        path.addCircle(BLCircle(0, 0, outerRadius), BL_GEOMETRY_DIRECTION_CW);
+        path.addCircle(BLCircle(0, 0, innerRadius), BL_GEOMETRY_DIRECTION_CCW);
+        break;
+    }
+    case SpinnerType::Star:
+    {
+        const int numPoints = 5;
+        const double outerRadius = size;
+        const double innerRadius = outerRadius * 0.4;
+
+        for (int i = 0; i < numPoints * 2; ++i)
+        {
+            double angle = i * M_PI / numPoints;
+            double radius = (i % 2 == 0) ? outerRadius : innerRadius;
+            double x = radius * std::cos(angle - M_PI / 2);
+            double y = radius * std::sin(angle - M_PI / 2);
+            if (i == 0)
+                path.moveTo(x, y);
+            else
+                path.lineTo(x, y);
+        }
+        path.close();
+        break;
+    }
+    case SpinnerType::Triangle:
+    {
+        double half = size / 2.0;
+        path.moveTo(0, -half);
+        path.lineTo(half, half);
+        path.lineTo(-half, half);
+        path.close();
+        break;
+    }
+    case SpinnerType::Circle:
+    case SpinnerType::Square:
+    case SpinnerType::Rectangle:
+        // Single primitives, the context draws them directly
+        break;
+    }
+
+    return path;
+}
@@ -0,0 +1,25 @@
+// Written by malekpour-dev.ir
+// ShapeCache keeps prebuilt Blend2D paths for shapes that are more than a single
+// primitive (ring, star, triangle), so they are built once per size instead of every frame.
+
+#pragma once
+
+#include <blend2d.h>
+#include <cstdint>
+#include <unordered_map>
+#include "Scene.h"
+
+class ShapeCache
+{
+public:
+    // Path centered on the origin, drawn through the context transform
+    const BLPath &path(SpinnerType type, int size);
+
+    void clear() { m_paths.clear(); }
+
+    // Uncached path of the same shape, empty for the single primitive shapes
+    static BLPath buildPath(SpinnerType type, int size);
+
+private:
+    std::unordered_map<uint64_t, BLPath> m_paths;
+};
@@ -0,0 +1,153 @@
+// Written by malekpour-dev.ir
+// SlotMap stores values contiguously in insertion (z-) order and hands out generational
+// handles, so lookups by handle are O(1) and a stale handle never reaches a newer value.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SlotMap
+{
+public:
+    // Handles are plain non-negative ints so they can travel through signals and QVariants:
+    // the slot index in the low bits, the slot generation above it
+    static constexpr int kIndexBits = 20;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static constexpr uint32_t kGenerationMask = (1u << (31 - kIndexBits)) - 1;
+
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+    using const_reverse_iterator = typename std::vector<T>::const_reverse_iterator;
+
+    // Appends a value on top of the z-order. T is constructed with its handle as first argument.
+    // Throws std::length_error once every slot index is live, like a full std::vector does,
+    // rather than hand out handles that alias another slot.
+    template <typename... Args>
+    T &emplace(Args &&...args)
+    {
+        uint32_t slot;
+        if (!m_freeSlots.empty())
+        {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        else
+        {
+            if (m_slots.size() > kIndexMask)
+                throw std::length_error("SlotMap: out of slot indices");
+
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back({kFree, 1});
+        }
+
+        m_values.emplace_back(makeHandle(slot), std::forward<Args>(args)...);
+        m_slots[slot].dense = static_cast<uint32_t>(m_values.size() - 1);
+        m_denseToSlot.push_back(slot);
+        return m_values.back();
+    }
+
+    // Keeps the order of the remaining values, so erasing is linear but lookups stay O(1)
+    bool erase(int handle)
+    {
+        int index = indexOf(handle);
+        if (index < 0)
+            return false;
+
+        uint32_t slot = m_denseToSlot[index];
+        m_values.erase(m_values.begin() + index);
+        m_denseToSlot.erase(m_denseToSlot.begin() + index);
+        for (size_t i = index; i < m_denseToSlot.size(); ++i)
+        {
+            m_slots[m_denseToSlot[i]].dense = static_cast<uint32_t>(i);
+        }
+
+        release(slot);
+        return true;
+    }
+
+    void clear()
+    {
+        for (uint32_t slot : m_denseToSlot)
+        {
+            release(slot);
+        }
+        m_values.clear();
+        m_denseToSlot.clear();
+    }
+
+    T *find(int handle)
+    {
+        int index = indexOf(handle);
+        return index >= 0 ? &m_values[index] : nullptr;
+    }
+
+    const T *find(int handle) const
+    {
+        int index = indexOf(handle);
+        return index >= 0 ? &m_values[index] : nullptr;
+    }
+
+    // Position of the value in the z-order, -1 for stale or unknown handles
+    int indexOf(int handle) const
+    {
+        if (handle < 0)
+            return -1;
+
+        uint32_t slot = static_cast<uint32_t>(handle) & kIndexMask;
+        uint32_t generation = static_cast<uint32_t>(handle) >> kIndexBits;
+        if (slot >= m_slots.size())
+            return -1;
+
+        const Slot &s = m_slots[slot];
+        if (s.dense == kFree || s.generation != generation)
+            return -1;
+        return static_cast<int>(s.dense);
+    }
+
+    size_t size() const { return m_values.size(); }
+    bool empty() const { return m_values.empty(); }
+
+    T &operator[](size_t index) { return m_values[index]; }
+    const T &operator[](size_t index) const { return m_values[index]; }
+
+    iterator begin() { return m_values.begin(); }
+    iterator end() { return m_values.end(); }
+    const_iterator begin() const { return m_values.begin(); }
+    const_iterator end() const { return m_values.end(); }
+    const_reverse_iterator rbegin() const { return m_values.rbegin(); }
+    const_reverse_iterator rend() const { return m_values.rend(); }
+
+private:
+    static constexpr uint32_t kFree = 0xFFFFFFFFu;
+
+    struct Slot
+    {
+        uint32_t dense;      // Index into m_values, kFree while unused
+        uint32_t generation; // Bumped on every release, never 0 so no handle is 0
+    };
+
+    int makeHandle(uint32_t slot) const
+    {
+        return static_cast<int>((m_slots[slot].generation << kIndexBits) | slot);
+    }
+
+    void release(uint32_t slot)
+    {
+        Slot &s = m_slots[slot];
+        s.dense = kFree;
+        s.generation = (s.generation + 1) & kGenerationMask;
+        if (s.generation == 0)
+            s.generation = 1;
+        m_freeSlots.push_back(slot);
+    }
+
+    std::vector<T> m_values;
+    std::vector<uint32_t> m_denseToSlot;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+};
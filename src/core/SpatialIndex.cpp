@@ -0,0 +1,188 @@
+// Written by malekpour-dev.ir
+// SpatialIndex is a uniform grid of boxes by id, so point and rectangle queries only
+// look at the items near the query instead of every item of the scene.
+
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+
+// Boxes spanning more cells than this are checked on every query instead of being linked
+// into each cell, a huge item would otherwise make every edit walk hundreds of cells
+static const int64_t kMaxLinkedCells = 256;
+
+static bool boxContains(const BLBox &box, const BLPoint &point)
+{
+    return point.x >= box.x0 && point.x < box.x1 && point.y >= box.y0 && point.y < box.y1;
+}
+
+static bool boxesIntersect(const BLBox &a, const BLBox &b)
+{
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+SpatialIndex::SpatialIndex(double cellSize)
+    : m_cellSize(cellSize)
+{
+}
+
+BLBoxI SpatialIndex::cellRange(const BLBox &box) const
+{
+    return BLBoxI(static_cast<int>(std::floor(box.x0 / m_cellSize)),
+                  static_cast<int>(std::floor(box.y0 / m_cellSize)),
+                  static_cast<int>(std::floor(box.x1 / m_cellSize)),
+                  static_cast<int>(std::floor(box.y1 / m_cellSize)));
+}
+
+uint64_t SpatialIndex::cellKey(int cellX, int cellY)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+}
+
+void SpatialIndex::link(int id, const Entry &entry)
+{
+    if (entry.large)
+    {
+        m_large.push_back(id);
+        return;
+    }
+
+    for (int y = entry.cells.y0; y <= entry.cells.y1; ++y)
+    {
+        for (int x = entry.cells.x0; x <= entry.cells.x1; ++x)
+        {
+            m_cells[cellKey(x, y)].push_back(id);
+        }
+    }
+}
+
+void SpatialIndex::unlink(int id, const Entry &entry)
+{
+    auto eraseFrom = [id](std::vector<int> &ids)
+    {
+        auto it = std::find(ids.begin(), ids.end(), id);
+        if (it != ids.end())
+        {
+            *it = ids.back();
+            ids.pop_back();
+        }
+    };
+
+    if (entry.large)
+    {
+        eraseFrom(m_large);
+        return;
+    }
+
+    for (int y = entry.cells.y0; y <= entry.cells.y1; ++y)
+    {
+        for (int x = entry.cells.x0; x <= entry.cells.x1; ++x)
+        {
+            auto cell = m_cells.find(cellKey(x, y));
+            if (cell == m_cells.end())
+                continue;
+
+            eraseFrom(cell->second);
+            if (cell->second.empty())
+                m_cells.erase(cell);
+        }
+    }
+}
+
+void SpatialIndex::update(int id, const BLBox &box)
+{
+    Entry entry;
+    entry.box = box;
+    entry.cells = cellRange(box);
+    entry.large = static_cast<int64_t>(entry.cells.x1 - entry.cells.x0 + 1) *
+                      (entry.cells.y1 - entry.cells.y0 + 1) > kMaxLinkedCells;
+
+    auto it = m_entries.find(id);
+    if (it != m_entries.end())
+    {
+        Entry &old = it->second;
+        bool sameCells = old.large == entry.large && old.cells.x0 == entry.cells.x0 &&
+                         old.cells.y0 == entry.cells.y0 && old.cells.x1 == entry.cells.x1 &&
+                         old.cells.y1 == entry.cells.y1;
+        if (!sameCells)
+        {
+            unlink(id, old);
+            link(id, entry);
+        }
+        old = entry;
+        return;
+    }
+
+    link(id, entry);
+    m_entries.emplace(id, entry);
+}
+
+void SpatialIndex::remove(int id)
+{
+    auto it = m_entries.find(id);
+    if (it == m_entries.end())
+        return;
+
+    unlink(id, it->second);
+    m_entries.erase(it);
+}
+
+void SpatialIndex::clear()
+{
+    m_cells.clear();
+    m_entries.clear();
+    m_large.clear();
+}
+
+void SpatialIndex::query(const BLPoint &point, std::vector<int> &ids) const
+{
+    int cellX = static_cast<int>(std::floor(point.x / m_cellSize));
+    int cellY = static_cast<int>(std::floor(point.y / m_cellSize));
+
+    auto cell = m_cells.find(cellKey(cellX, cellY));
+    if (cell != m_cells.end())
+    {
+        for (int id : cell->second)
+        {
+            if (boxContains(m_entries.at(id).box, point))
+                ids.push_back(id);
+        }
+    }
+
+    for (int id : m_large)
+    {
+        if (boxContains(m_entries.at(id).box, point))
+            ids.push_back(id);
+    }
+}
+
+void SpatialIndex::query(const BLBox &rect, std::vector<int> &ids) const
+{
+    BLBoxI range = cellRange(rect);
+
+    for (int y = range.y0; y <= range.y1; ++y)
+    {
+        for (int x = range.x0; x <= range.x1; ++x)
+        {
+            auto cell = m_cells.find(cellKey(x, y));
+            if (cell == m_cells.end())
+                continue;
+
+            for (int id : cell->second)
+            {
+                const Entry &entry = m_entries.at(id);
+
+                // A box linked into several cells of the range is reported from the first one only
+                if (x != std::max(range.x0, entry.cells.x0) || y != std::max(range.y0, entry.cells.y0))
+                    continue;
+                if (boxesIntersect(entry.box, rect))
+                    ids.push_back(id);
+            }
+        }
+    }
+
+    for (int id : m_large)
+    {
+        if (boxesIntersect(m_entries.at(id).box, rect))
+            ids.push_back(id);
+    }
+}
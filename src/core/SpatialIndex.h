@@ -0,0 +1,46 @@
+// Written by malekpour-dev.ir
+// SpatialIndex is a uniform grid of boxes by id, so point and rectangle queries only
+// look at the items near the query instead of every item of the scene.
+
+#pragma once
+
+#include <blend2d.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class SpatialIndex
+{
+public:
+    explicit SpatialIndex(double cellSize = 64.0);
+
+    // Adds the id, or moves it when it is already indexed
+    void update(int id, const BLBox &box);
+    void remove(int id);
+    void clear();
+
+    // Appends the ids whose box contains the point or intersects the rectangle, each once
+    // and in no particular order
+    void query(const BLPoint &point, std::vector<int> &ids) const;
+    void query(const BLBox &rect, std::vector<int> &ids) const;
+
+    size_t size() const { return m_entries.size(); }
+
+private:
+    struct Entry
+    {
+        BLBox box;
+        BLBoxI cells; // Inclusive cell range the box is linked into
+        bool large;   // Covers too many cells, kept in m_large instead
+    };
+
+    BLBoxI cellRange(const BLBox &box) const;
+    static uint64_t cellKey(int cellX, int cellY);
+    void link(int id, const Entry &entry);
+    void unlink(int id, const Entry &entry);
+
+    double m_cellSize;
+    std::unordered_map<uint64_t, std::vector<int>> m_cells;
+    std::unordered_map<int, Entry> m_entries;
+    std::vector<int> m_large;
+};
@@ -0,0 +1,165 @@
+// Written by malekpour-dev.ir
+// StaticLayer caches the pixels of items that look the same from frame to frame
+// (no animation, or waiting in a delay phase), so a frame only rasterizes what moves.
+
+#include "StaticLayer.h"
+#include <algorithm>
+#include <cmath>
+
+// More stale areas than this in one frame are merged into their bounding box
+static const size_t kMaxStaleAreas = 16;
+
+static bool boxesIntersect(const BLBox &a, const BLBox &b)
+{
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+static bool sameBox(const BLBox &a, const BLBox &b)
+{
+    return a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+}
+
+void StaticLayer::resize(int width, int height)
+{
+    if (width == m_width && height == m_height)
+        return;
+
+    m_width = width;
+    m_height = height;
+
+    if (width > 0 && height > 0)
+        m_image.create(width, height, BL_FORMAT_PRGB32);
+    else
+        m_image.reset();
+
+    m_cached.clear();
+    invalidateAll();
+}
+
+void StaticLayer::invalidate(const BLBox &box)
+{
+    addStale(box);
+}
+
+void StaticLayer::invalidateAll()
+{
+    m_stale.clear();
+    m_stale.push_back(BLBoxI(0, 0, m_width, m_height));
+}
+
+void StaticLayer::addStale(const BLBox &box)
+{
+    BLBoxI area(std::max(0, static_cast<int>(std::floor(box.x0))),
+                std::max(0, static_cast<int>(std::floor(box.y0))),
+                std::min(m_width, static_cast<int>(std::ceil(box.x1))),
+                std::min(m_height, static_cast<int>(std::ceil(box.y1))));
+    if (area.x0 >= area.x1 || area.y0 >= area.y1)
+        return;
+
+    if (m_stale.size() >= kMaxStaleAreas)
+    {
+        for (const BLBoxI &stale : m_stale)
+        {
+            area.x0 = std::min(area.x0, stale.x0);
+            area.y0 = std::min(area.y0, stale.y0);
+            area.x1 = std::max(area.x1, stale.x1);
+            area.y1 = std::max(area.y1, stale.y1);
+        }
+        m_stale.clear();
+    }
+
+    m_stale.push_back(area);
+}
+
+void StaticLayer::update(const Scene &scene, const AnimationEvaluator &poses, SceneRenderer &renderer, int pinnedId)
+{
+    const auto &items = scene.items();
+    m_cachedFlags.assign(items.size(), 0);
+    m_boxes.resize(items.size());
+    m_liveBoxes.clear();
+    m_nextCached.clear();
+
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const SpinnerItem &item = items[i];
+        bool live = item.id == pinnedId || poses.isAnimating(i);
+        m_boxes[i] = live ? SceneRenderer::sweptBounds(item) : poses.bounds(i);
+
+        // A static item may only come from the cache when nothing drawn live lies below it,
+        // otherwise compositing the live items on top of the cache would break the z-order
+        if (!live)
+        {
+            bool covered = std::any_of(m_liveBoxes.begin(), m_liveBoxes.end(),
+                                       [&](const BLBox &liveBox)
+                                       {
+                                           return boxesIntersect(liveBox, m_boxes[i]);
+                                       });
+            if (!covered)
+            {
+                m_cachedFlags[i] = 1;
+                m_nextCached.emplace(item.id, m_boxes[i]);
+                continue;
+            }
+        }
+
+        m_liveBoxes.push_back(m_boxes[i]);
+    }
+
+    // Items that joined, left or moved inside the cache make their areas stale
+    for (const auto &entry : m_cached)
+    {
+        auto next = m_nextCached.find(entry.first);
+        if (next == m_nextCached.end())
+        {
+            addStale(entry.second);
+        }
+        else if (!sameBox(next->second, entry.second))
+        {
+            addStale(entry.second);
+            addStale(next->second);
+        }
+    }
+    for (const auto &entry : m_nextCached)
+    {
+        if (m_cached.find(entry.first) == m_cached.end())
+            addStale(entry.second);
+    }
+    m_cached.swap(m_nextCached);
+
+    if (m_stale.empty() || m_image.empty())
+    {
+        m_stale.clear();
+        return;
+    }
+
+    BLContext ctx(m_image, renderer.createInfo(m_width, m_height));
+    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+
+    for (const BLBoxI &stale : m_stale)
+    {
+        BLRectI area(stale.x0, stale.y0, stale.x1 - stale.x0, stale.y1 - stale.y0);
+        BLBox staleBox(stale.x0, stale.y0, stale.x1, stale.y1);
+
+        ctx.clipToRect(area);
+        ctx.clearRect(area);
+
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            if (m_cachedFlags[i] && boxesIntersect(m_boxes[i], staleBox))
+                renderer.drawItem(ctx, items[i], poses.transform(i), poses.alpha(i));
+        }
+
+        ctx.resetTransform();
+        ctx.restoreClipping();
+    }
+
+    ctx.end();
+    m_stale.clear();
+}
+
+void StaticLayer::composite(BLContext &ctx, const BLRectI &area) const
+{
+    ctx.setCompOp(BL_COMP_OP_SRC_COPY);
+    ctx.blitImage(BLPointI(area.x, area.y), m_image, area);
+    ctx.setCompOp(BL_COMP_OP_SRC_OVER);
+}
@@ -0,0 +1,49 @@
+// Written by malekpour-dev.ir
+// StaticLayer caches the pixels of items that look the same from frame to frame
+// (no animation, or waiting in a delay phase), so a frame only rasterizes what moves.
+
+#pragma once
+
+#include <blend2d.h>
+#include <unordered_map>
+#include <vector>
+#include "AnimationEvaluator.h"
+#include "Scene.h"
+#include "SceneRenderer.h"
+
+class StaticLayer
+{
+public:
+    // Matches the layer to the target size, a size change drops the whole cache
+    void resize(int width, int height);
+
+    // Marks an area stale, for edits the layer cannot see by itself (color, size...)
+    void invalidate(const BLBox &box);
+    void invalidateAll();
+
+    // Decides which items are served from the cache, using poses the evaluator computed for
+    // this scene, and redraws stale areas. The pinned item is always drawn live, e.g. the
+    // selected item while it is edited.
+    void update(const Scene &scene, const AnimationEvaluator &poses, SceneRenderer &renderer, int pinnedId = -1);
+
+    // Index into scene.items() of the last update()
+    bool isCached(size_t index) const { return index < m_cachedFlags.size() && m_cachedFlags[index]; }
+
+    // Copies the cached pixels of an area into the context
+    void composite(BLContext &ctx, const BLRectI &area) const;
+
+private:
+    void addStale(const BLBox &box);
+
+    BLImage m_image;
+    int m_width = 0;
+    int m_height = 0;
+
+    // Box each cached item was drawn with, by item id
+    std::unordered_map<int, BLBox> m_cached;
+    std::unordered_map<int, BLBox> m_nextCached;
+    std::vector<char> m_cachedFlags;
+    std::vector<BLBox> m_boxes;
+    std::vector<BLBox> m_liveBoxes;
+    std::vector<BLBoxI> m_stale;
+};
@@ -0,0 +1,41 @@
+// Written by malekpour-dev.ir
+// TripleBuffer hands complete values from one writer thread to one reader thread without
+// locks. The writer never waits for the reader and the reader always gets the newest value.
+
+#pragma once
+
+#include <atomic>
+
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Writer side. The back slot is private to the writer until publish() swaps it out.
+    T &back() { return m_slots[m_back]; }
+    int backIndex() const { return m_back; }
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Reader side. Takes the newest published slot, false when nothing new was published
+    // since the last call. front() stays valid until the next acquire().
+    bool acquire()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & kFresh))
+            return false;
+
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+    const T &front() const { return m_slots[m_front]; }
+
+private:
+    static constexpr int kIndexMask = 3;
+    static constexpr int kFresh = 4; // Middle slot was published and not taken yet
+
+    T m_slots[3];
+    int m_back = 0;
+    int m_front = 1;
+    std::atomic<int> m_middle{2};
+};